@@ -11,6 +11,8 @@
 
 #include <iostream>
 #include <fstream>
+#include <sstream>
+#include <string>
 
 #define INF 1000000000  // Represents an infinite distance
 #define MAX_NODES 1000  // Maximum number of nodes allowed in the graph
@@ -23,6 +25,40 @@ int distancesArray[MAX_NODES];        // Stores the minimum distances from a sta
 bool visitedNodes[MAX_NODES];         // Tracks visited nodes in Dijkstra
 int floydDistancesMatrix[MAX_NODES][MAX_NODES];  // Matrix that stores the shortest distances in Floyd-Warshall
 
+/*
+    Function that reads the next integer of the input buffer, skipping any whitespace before it.
+    Input: A pointer to the current position in the buffer, moved past the number, the end of the buffer,
+    and the variable receiving the value.
+    Output: Returns true if an integer was read; false at the end of the input or if the next token is not
+    an optional '-' followed by digits and whitespace or the end of the input.
+    Complexity of readInt: O(k), where k is the number of characters consumed.
+*/
+bool readInt(const char*& p, const char* end, int& value) {
+    while (p < end && (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r')) {
+        p++;
+    }
+    bool negative = false;
+    if (p < end && *p == '-') {
+        negative = true;
+        p++;
+    }
+    if (p == end || *p < '0' || *p > '9') {
+        return false;
+    }
+    value = 0;
+    while (p < end && *p >= '0' && *p <= '9') {
+        value = value * 10 + (*p - '0');
+        p++;
+    }
+    if (p < end && *p != ' ' && *p != '\t' && *p != '\n' && *p != '\r') {
+        return false;  // Digits followed by other characters, e.g. "12x"
+    }
+    if (negative) {
+        value = -value;
+    }
+    return true;
+}
+
 /*
     Main function that reads input data and executes the Dijkstra and Floyd-Warshall algorithms.
     Input: Reads an adjacency matrix representing the distances between nodes in a graph.
@@ -33,19 +69,31 @@ int floydDistancesMatrix[MAX_NODES][MAX_NODES];  // Matrix that stores the short
     In total, the complexity of the main function is O(n^3).
 */
 int main() {
-    // Read data from standard input using a file buffer
-    ifstream inputFile;
-    inputFile.std::basic_ios<char>::rdbuf(std::cin.rdbuf());
+    // Read the whole standard input into one buffer and parse it in place, which avoids the
+    // per-value overhead of formatted stream extraction on large matrices
+    ostringstream contents;
+    contents << cin.rdbuf();
+    string input = contents.str();
+    const char* cursor = input.data();
+    const char* inputEnd = cursor + input.size();
 
     // Read the number of nodes in the graph
-    inputFile >> nodeCount;
+    if (!readInt(cursor, inputEnd, nodeCount)) {
+        cerr << "Error: expected the number of nodes" << endl;
+        return 1;
+    }
+    if (nodeCount < 0 || nodeCount > MAX_NODES) {
+        cerr << "Error: the number of nodes must be between 0 and " << MAX_NODES << ", got " << nodeCount << endl;
+        return 1;
+    }
 
     // Read the adjacency matrix representing the distances between nodes
     for (int i = 0; i < nodeCount; ++i) {
         for (int j = 0; j < nodeCount; ++j) {
-            int weight;
-            inputFile >> weight;
-            adjMatrix[i][j] = weight;
+            if (!readInt(cursor, inputEnd, adjMatrix[i][j])) {
+                cerr << "Error: expected an integer for row " << i << ", column " << j << " of the matrix" << endl;
+                return 1;
+            }
         }
     }
 
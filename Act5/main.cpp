@@ -1,10 +1,10 @@
 /*
-    Program that implements Dijkstra’s Algorithm using an adjacency list and a min-heap.
+    Program that implements Dijkstra’s Algorithm using a compressed sparse row graph and a min-heap.
     It reads a graph from an input file, processes it, and determines the shortest path
     from a specified starting node to all other nodes.  
     Author: Diego Ivan Morales Gallardo A01643382
     Creation date: September 26, 2024
-    Overall complexity: The program implements Dijkstra's Algorithm using an adjacency list and a min-heap.
+    Overall complexity: The program implements Dijkstra's Algorithm using a compressed sparse row graph and a min-heap.
     The algorithm has a time complexity of O((n + m) log n), where n is the number of nodes and m is the number of edges.
     The heap operations (insertion, extraction, and updates) take O(log n) time, and the relaxation of edges is performed
     for each edge in the graph, resulting in an efficient handling of sparse graphs.
@@ -12,238 +12,6688 @@
 
 #include <iostream>
 #include <fstream>
+#include <sstream>
+#include <vector>
+#include <algorithm>
+#include <functional>
+#include <utility>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+#include <climits>
+#include <limits>
+#include <cmath>
+#include <random>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#endif
 
-#define NODES_MAX 321271  // Maximum number of nodes (indexed from 1)
+#define NODE_ID_LIMIT (INT_MAX - 1)  // Node ids must stay below this so that nodeCount + 1 fits an int
 #define INF 1000000000    // A large value representing infinity
+#define SETTLED -2        // heapPos value of a node whose distance is final
+#define GRAPH_FILE_MAGIC 0x31525343    // "CSR1" written at the start of a binary graph file
+#define GRAPH_FILE_VERSION 2     // Version 2 stores packed (target, weight) arcs
+#define OUTPUT_BUFFER_SIZE (1 << 20)   // Bytes collected by a ResultWriter before each write() call
 
-// Structure representing an edge in the adjacency list
-struct Edge {
-    int to;        // Destination node of the edge
-    int weight;    // Weight of the edge
-    Edge* next;    // Pointer to the next edge in the adjacency list
+// Arc with a weight of type W; with 32-bit weights it packs into 64 bits, so a relaxation reads its
+// head and weight with a single load
+template <class W>
+struct BasicArc {
+    int target;    // Destination node
+    W weight;      // Weight of the arc
 };
 
+// Structure representing the graph in compressed sparse row (CSR) form: the arcs leaving node u are
+// stored contiguously at positions offsets[u] .. offsets[u + 1] - 1 of arcs[]
+template <class W>
+struct BasicGraph {
+    int nodeCount;   // Number of node slots (largest node id + 1)
+    int arcCount;    // Number of arcs
+    int* offsets;    // First arc of each node, nodeCount + 1 entries
+    BasicArc<W>* arcs;  // Arcs of every node, sorted by target within a node
+    void* mapping;      // Start of the memory mapped file backing the arrays, or NULL if heap allocated
+    size_t mappingSize; // Length of the mapping in bytes
+};
+
+// The int instances are used by every engine; the other weight types only by --weights
+typedef BasicArc<int> Arc;
+typedef BasicGraph<int> Graph;
+
+// Header of the binary graph file; the offsets and arcs arrays follow it in this order
+struct GraphFileHeader {
+    uint32_t magic;      // GRAPH_FILE_MAGIC
+    uint32_t version;    // GRAPH_FILE_VERSION
+    uint32_t nodeCount;  // Number of node slots
+    uint32_t arcCount;   // Number of arcs
+    uint64_t checksum;   // FNV-1a hash of the three arrays
+};
+
+// Priority queue used by Dijkstra's algorithm, chosen at runtime with --queue
+enum QueueKind {
+    QUEUE_BINARY,   // Indexed binary min-heap with decrease-key (heap/heapPos arrays)
+    QUEUE_RADIX,    // Radix heap for monotone integer keys
+    QUEUE_DIAL,     // Dial's circular bucket queue, one bucket per distance value modulo (max weight + 1)
+    QUEUE_DARY2,    // d-ary heaps storing (key, node) pairs, with arity 2, 4 or 8
+    QUEUE_DARY4,
+    QUEUE_DARY8
+};
+
+// Entry of a d-ary heap; keeping the key next to the node lets sift operations compare children
+// without looking up dist[] at random positions
+template <class W>
+struct BasicHeapEntry {
+    W key;
+    int node;
+};
+
+typedef BasicHeapEntry<int> HeapEntry;
+
+// Radix heap: entry (key, node) lives in bucket 0 if key equals the last extracted key, otherwise in the
+// bucket given by the highest bit in which key differs from it. Because Dijkstra extracts keys in
+// non-decreasing order, each entry only moves to lower buckets, at most 32 times. Outdated entries of a
+// node whose distance decreased are left in place and skipped by the search once the node is visited.
+struct RadixHeap {
+    std::vector<std::pair<unsigned, int> > buckets[33];
+    unsigned last;   // Last extracted key
+    size_t count;    // Number of stored entries
+};
+
+// Dial's bucket queue: live keys always lie in [current, current + max weight], so a circular array
+// of max weight + 1 node lists indexed by key modulo its size holds them without collisions
+struct BucketQueue {
+    std::vector<std::vector<int> > buckets;
+    long long current;   // Key of the bucket being emptied
+    size_t count;        // Number of stored entries
+};
+
+// Operation counts of the Dijkstra searches run on a state, accumulated over all its searches
+struct SearchCounters {
+    long long settled;        // Nodes settled
+    long long relaxedArcs;    // Arcs scanned from settled nodes
+    long long pushes;         // Queue insertions (lazy queues insert again instead of decreasing a key)
+    long long decreaseKeys;   // Key decreases of nodes already held by an indexed heap
+    long long pops;           // Queue extractions, including outdated entries of lazy queues
+    long long maxQueueSize;   // Largest number of queued entries seen
+};
+
+// Per-search state of Dijkstra's algorithm with distances of type W. Entries are only valid when stamp[v]
+// equals round, so a new search starts by incrementing round instead of re-initialising every array
+template <class W>
+struct BasicSearchState {
+    W* dist;          // Distance array for shortest paths
+    int* heap;        // Min-heap for priority queue implementation
+    int* heapPos;     // Position of each node in the heap, -1 if not queued, SETTLED once settled
+    int* pred;        // Predecessor of each node on its shortest path, -1 for the source
+    int* stamp;       // Search round in which each node was last touched
+    int nodeCount;    // Number of node slots covered by the arrays
+    int heapSize;     // Size of the min-heap
+    int round;        // Number of the current search
+    RadixHeap radixHeap;       // Queue used when queueKind is QUEUE_RADIX
+    BucketQueue bucketQueue;   // Queue used when queueKind is QUEUE_DIAL
+    std::vector<BasicHeapEntry<W> > dAryEntries;  // Array of the d-ary heaps, positions tracked in heapPos
+    SearchCounters counters;   // Work done by dijkstraWithQueue on this state
+};
+
+typedef BasicSearchState<int> SearchState;
+
+// Optional stopping rules of a single-source search; the search stops as soon as one of them is met
+template <class W>
+struct BasicSearchLimits {
+    W radius;                   // Largest distance to settle (INF: unbounded)
+    int maxSettled;             // Number of nodes to settle (0: unlimited)
+    const char* isTarget;       // Marks of the target set, or NULL
+    int targetCount;            // Number of marked nodes; the search stops once all are settled
+    std::vector<int>* settled;  // Receives the settled nodes in order of distance, or NULL
+};
+
+typedef BasicSearchLimits<int> SearchLimits;
+
 // Global variables for graph representation and Dijkstra's algorithm
-Edge* adj[NODES_MAX];       // Adjacency list for graph representation
-int dist[NODES_MAX];        // Distance array for shortest paths
-bool visited[NODES_MAX];    // Array to mark visited nodes
-int heap[NODES_MAX];        // Min-heap for priority queue implementation
-int heapPos[NODES_MAX];     // Position of each node in the heap
-int heapSize = 0;           // Size of the min-heap
+Graph graph = {0, 0, NULL, NULL, NULL, 0};  // CSR graph representation
+Graph reverseGraph = {0, 0, NULL, NULL, NULL, 0};  // Reverse CSR graph, built at load time with --bidir
+bool bidirectionalQueries = false;   // Answer point-to-point queries with bidirectional Dijkstra
+QueueKind queueKind = QUEUE_BINARY;  // Priority queue used by dijkstra()
+int dialBucketCount = 1;             // Bucket count of Dial's queue (largest arc weight + 1)
+
+/*
+    Function: parseEightDigits
+    Converts eight ASCII digits loaded into a 64-bit word (first digit in the lowest byte) with three
+    multiply-and-shift steps that combine digit pairs, then pairs of pairs, then the two halves.
+    Parameters:
+        word: The eight digit characters.
+    Returns:
+        Their decimal value.
+    parseEightDigits complexity: O(1).
+*/
+inline uint64_t parseEightDigits(uint64_t word) {
+    word -= 0x3030303030303030ULL;
+    word = word * 10 + (word >> 8);
+    return ((word & 0x000000FF000000FFULL) * (100 + (1000000ULL << 32)) +
+            ((word >> 16) & 0x000000FF000000FFULL) * (1 + (10000ULL << 32))) >> 32;
+}
+
+/*
+    Function: parseShortDigits
+    Converts 1 to 8 digits by padding them on the left with '0' characters up to a full word.
+    Parameters:
+        str: The first digit; 8 bytes must be readable from it.
+        len: Number of digits.
+    Returns:
+        Their decimal value.
+    parseShortDigits complexity: O(1).
+*/
+inline uint64_t parseShortDigits(const char* str, int len) {
+    uint64_t word;
+    memcpy(&word, str, sizeof(word));
+    word <<= 8 * (8 - len);
+    if (len < 8) {
+        word |= 0x3030303030303030ULL >> (8 * len);
+    }
+    return parseEightDigits(word);
+}
 
 /*
-    Function: parseInt
-    Converts a substring of a character buffer into an integer.
-    Skips spaces and extracts digits to form the integer value.
+    Function: parseNumber
+    Skips spaces and tabs and reads the unsigned integer that follows. When at least 16 bytes remain the
+    digits are located with one SSE2 comparison over 16 characters, whose movemask gives the token length
+    directly, and converted eight at a time; otherwise, and on targets without SSE2, it falls back to
+    reading one character per iteration.
     Parameters:
-        str: The character buffer containing the input string.
-        index: The current position in the buffer, updated during parsing.
+        p: Current position, moved past the number.
+        end: End of the readable input; bytes up to it may be loaded even past the current line.
     Returns:
-        The parsed integer value.
-    parseInt complexity: O(k), where k is the number of characters in the string to parse the integer.
+        The parsed value.
+    parseNumber complexity: O(1) for numbers of up to 15 digits on the vector path, O(k) otherwise.
 */
-int parseInt(char* str, int& index) {
-    while (str[index] == ' ' || str[index] == '\t') {
-        index++;
+inline long long parseNumber(const char*& p, const char* end) {
+    while (p < end && (*p == ' ' || *p == '\t')) {
+        p++;
+    }
+#if defined(__SSE2__)
+    if (end - p >= 16) {
+        __m128i chars = _mm_loadu_si128((const __m128i*)p);
+        __m128i isDigit = _mm_and_si128(_mm_cmpgt_epi8(chars, _mm_set1_epi8('0' - 1)),
+                                        _mm_cmplt_epi8(chars, _mm_set1_epi8('9' + 1)));
+        int len = __builtin_ctz(~_mm_movemask_epi8(isDigit));
+        if (len < 16) {
+            long long val = 0;
+            if (len > 8) {
+                val = parseShortDigits(p, len - 8) * 100000000ULL + parseShortDigits(p + len - 8, 8);
+            } else if (len > 0) {
+                val = parseShortDigits(p, len);
+            }
+            p += len;
+            return val;
+        }
     }
-    
-    int val = 0;
-    while (str[index] >= '0' && str[index] <= '9') {
-        val = val * 10 + (str[index] - '0');
-        index++;
+#endif
+    long long val = 0;
+    while (p < end && *p >= '0' && *p <= '9') {
+        val = val * 10 + (*p - '0');
+        p++;
     }
     return val;
 }
 
 /*
-    Function: swap
-    Swaps two elements in the heap and updates their positions.
+    Function: parseBoundedNumber
+    Reads an unsigned integer with parseNumber and checks that it is at most a limit. Tokens of more than
+    18 digits are rejected before they can wrap the 64-bit accumulator.
     Parameters:
-        i: Index of the first element in the heap.
-        j: Index of the second element in the heap.
-    swap complexity: O(1), constant time to swap two elements in the heap and update their positions.
+        p: Current position, moved past the number.
+        end: End of the readable input.
+        limit: Largest accepted value.
+        value: Receives the parsed value.
+    Returns:
+        True if the number fits the limit.
+    parseBoundedNumber complexity: O(1) for numbers of up to 15 digits, O(k) otherwise.
 */
-void swap(int i, int j) {
-    int temp = heap[i];
-    heap[i] = heap[j];
-    heap[j] = temp;
-    heapPos[heap[i]] = i;
-    heapPos[heap[j]] = j;
+inline bool parseBoundedNumber(const char*& p, const char* end, long long limit, long long& value) {
+    while (p < end && (*p == ' ' || *p == '\t')) {
+        p++;
+    }
+    const char* start = p;
+    value = parseNumber(p, end);
+    return p - start <= 18 && value <= limit;
 }
 
 /*
-    Function: siftUp
-    Reorganizes the heap by moving a node upward to maintain heap order.
+    Weight types
+    The graph, the search state, the heaps and the Dijkstra loop are templates over the weight type W, which
+    is also the distance type. Each instance is compiled separately, so the relaxation loop of one weight
+    type contains no tests for the others. WeightTraits<W> gives the distance of unreached nodes, the
+    extension of a path by one arc, and the parsing of a weight from a DIMACS arc line, which fails for
+    weights that do not fit W below its infinity.
+    int (with INF) is used by every engine; uint32 saturates at its infinity instead of wrapping, so longer
+    paths read as unreachable, uint64 holds the sums of continent-sized graphs, and float takes fractional
+    weights.
+*/
+
+template <class W>
+struct WeightTraits;
+
+template <>
+struct WeightTraits<int> {
+    static const char* name() { return "int"; }
+    static int infinity() { return INF; }
+    static int add(int d, int w) { return d + w; }
+    static bool parse(const char*& p, const char* end, int& weight) {
+        long long value;
+        bool fits = parseBoundedNumber(p, end, INF - 1, value);
+        weight = value;
+        return fits;
+    }
+};
+
+template <>
+struct WeightTraits<uint32_t> {
+    static const char* name() { return "uint32"; }
+    static uint32_t infinity() { return UINT32_MAX; }
+    static uint32_t add(uint32_t d, uint32_t w) {
+        uint64_t sum = (uint64_t)d + w;
+        return sum < UINT32_MAX ? (uint32_t)sum : UINT32_MAX;
+    }
+    static bool parse(const char*& p, const char* end, uint32_t& weight) {
+        long long value;
+        bool fits = parseBoundedNumber(p, end, UINT32_MAX - 1, value);
+        weight = value;
+        return fits;
+    }
+};
+
+template <>
+struct WeightTraits<uint64_t> {
+    static const char* name() { return "uint64"; }
+    static uint64_t infinity() { return UINT64_MAX; }
+    static uint64_t add(uint64_t d, uint64_t w) { return d + w; }
+    static bool parse(const char*& p, const char* end, uint64_t& weight) {
+        long long value;
+        bool fits = parseBoundedNumber(p, end, LLONG_MAX, value);
+        weight = value;
+        return fits;
+    }
+};
+
+template <>
+struct WeightTraits<float> {
+    static const char* name() { return "float"; }
+    static float infinity() { return std::numeric_limits<float>::infinity(); }
+    static float add(float d, float w) { return d + w; }
+    static bool parse(const char*& p, const char*, float& weight) {
+        char* next;
+        weight = strtof(p, &next);  // The line buffer is zero-terminated
+        p = next;
+        return weight < infinity();  // Overflow gives infinity, which is also false for NaN
+    }
+};
+
+/*
+    Function: arcLess
+    Orders arcs by target, then by weight, so that parallel arcs come lightest first.
     Parameters:
-        idx: The index of the node to be sifted up in the heap.
-    siftUp complexity: O(log n), where n is the number of nodes in the heap. The function maintains the heap order
-    by moving a node upwards, and in the worst case, it travels up the height of the heap, which is log n.
+        a: The first arc.
+        b: The second arc.
+    Returns:
+        True if a comes before b.
+    arcLess complexity: O(1).
 */
-void siftUp(int idx) {
-    while (idx > 1 && dist[heap[idx]] < dist[heap[idx / 2]]) {
-        swap(idx, idx / 2);
-        idx = idx / 2;
+template <class W>
+inline bool arcLess(const BasicArc<W>& a, const BasicArc<W>& b) {
+    return a.target < b.target || (a.target == b.target && a.weight < b.weight);
+}
+
+/*
+    Function: sortArcSlices
+    Sorts the arcs of every node in a range by target so that relaxations walk dist[] in increasing order.
+    Parameters:
+        g: The graph.
+        beginNode: First node of the range.
+        endNode: One past the last node of the range.
+    sortArcSlices complexity: O(m' log d) for the m' arcs of the range.
+*/
+template <class W>
+void sortArcSlices(BasicGraph<W>& g, int beginNode, int endNode) {
+    for (int u = beginNode; u < endNode; u++) {
+        std::sort(g.arcs + g.offsets[u], g.arcs + g.offsets[u + 1], arcLess<W>);
     }
 }
 
 /*
-    Function: siftDown
-    Reorganizes the heap by moving a node downward to maintain heap order.
+    Function: loadGraph
+    Reads a graph in DIMACS shortest path format and stores it in CSR form with weights of type W.
+    The arcs are first collected in reading order while counting the out-degree of every node; a prefix sum
+    over the degrees then gives each node its slice of the arc arrays, and a second pass scatters the arcs
+    into place and sorts every slice by target.
     Parameters:
-        idx: The index of the node to be sifted down in the heap.
-    siftDown complexity: O(log n), where n is the number of nodes in the heap. This function ensures that the heap
-    order is maintained by moving a node downwards, with a worst-case time of log n, proportional to the height of the heap.
+        inFile: The stream containing the graph data.
+    Returns:
+        The loaded graph.
+    loadGraph complexity: O(n + m log d), where d is the largest out-degree.
 */
-void siftDown(int idx) {
-    while (2 * idx <= heapSize) {
-        int child = 2 * idx;
-        if (child + 1 <= heapSize && dist[heap[child + 1]] < dist[heap[child]]) {
-            child++;
+template <class W = int>
+BasicGraph<W> loadGraph(std::istream& inFile) {
+    std::vector<int> arcFrom, arcTo;
+    std::vector<W> arcWeight;
+    std::vector<int> degree;   // Grown on demand; the p line sizes it up front
+    int nodeCount = 0;
+
+    // First pass: read arc lines and count out-degrees
+    // Zero-filled so that parseNumber may load the full buffer past the end of a short line
+    char buffer[256] = {0};
+    const char* bufferEnd = buffer + sizeof(buffer);
+    while (inFile.getline(buffer, 256)) {
+        if (buffer[0] == 'p') {
+            // Problem line "p [sp] <nodes> <arcs>": reserve room for the arcs
+            const char* p = buffer + 1;
+            while (*p != '\0' && (*p < '0' || *p > '9')) {
+                p++;
+            }
+            long long nodes = parseNumber(p, bufferEnd);
+            long long arcs = parseNumber(p, bufferEnd);
+            if (nodes >= NODE_ID_LIMIT || arcs > INT_MAX) {
+                throw std::runtime_error("Graph too large in line: " + std::string(buffer));
+            }
+            nodeCount = std::max(nodeCount, (int)nodes + 1);
+            degree.resize(std::max((int)degree.size(), nodeCount), 0);
+            arcFrom.reserve(arcs);
+            arcTo.reserve(arcs);
+            arcWeight.reserve(arcs);
+        } else if (buffer[0] == 'a') {
+            // Process arc lines that define edges in the graph
+            const char* p = buffer + 1;
+            long long fromNode = parseNumber(p, bufferEnd);  // Source node
+            long long toNode = parseNumber(p, bufferEnd);    // Destination node
+            W edgeWeight;  // Weight of the edge
+            if (!WeightTraits<W>::parse(p, bufferEnd, edgeWeight)) {
+                throw std::runtime_error("Weight too large in line: " + std::string(buffer));
+            }
+            if (fromNode >= NODE_ID_LIMIT || toNode >= NODE_ID_LIMIT) {
+                throw std::runtime_error("Node id too large in line: " + std::string(buffer));
+            }
+            nodeCount = std::max(nodeCount, (int)std::max(fromNode, toNode) + 1);
+            if (fromNode >= (long long)degree.size()) {
+                degree.resize(std::max((size_t)fromNode + 1, 2 * degree.size()), 0);
+            }
+
+            arcFrom.push_back(fromNode);
+            arcTo.push_back(toNode);
+            arcWeight.push_back(edgeWeight);
+            degree[fromNode]++;
         }
-        if (dist[heap[idx]] <= dist[heap[child]]) {
-            idx = heapSize + 1;  // Exit the loop
-        } else {
-            swap(idx, child);
-            idx = child;
+        // Comment lines ('c') and anything else are skipped
+    }
+
+    degree.resize(nodeCount, 0);
+    BasicGraph<W> result;
+    result.mapping = NULL;
+    result.mappingSize = 0;
+    result.nodeCount = nodeCount;
+    result.arcCount = arcFrom.size();
+    result.offsets = new int[nodeCount + 1];
+    result.arcs = new BasicArc<W>[result.arcCount];
+
+    // Prefix sum of the degrees gives the first arc of every node
+    result.offsets[0] = 0;
+    for (int u = 0; u < nodeCount; u++) {
+        result.offsets[u + 1] = result.offsets[u] + degree[u];
+        degree[u] = result.offsets[u];  // Reused as the insertion cursor of node u
+    }
+
+    // Second pass: scatter the arcs into their slices
+    for (int i = 0; i < result.arcCount; i++) {
+        int pos = degree[arcFrom[i]]++;
+        result.arcs[pos].target = arcTo[i];
+        result.arcs[pos].weight = arcWeight[i];
+    }
+
+    sortArcSlices(result, 0, nodeCount);
+    return result;
+}
+
+// Arcs parsed by one thread from its chunk of a DIMACS file, in file order
+struct ParsedChunk {
+    std::vector<int> arcFrom, arcTo, arcWeight;
+    std::vector<int> degree;   // Out-degree of every node among the chunk's arcs
+    int nodeCount;             // Largest node id seen or declared in the chunk + 1
+    std::string error;         // Non-empty if the chunk could not be parsed
+};
+
+/*
+    Function: parseDimacsChunk
+    Parses the lines of one newline-aligned chunk of a DIMACS file into the chunk's arc buffers.
+    Parameters:
+        begin: First character of the chunk (start of a line).
+        end: One past the last character of the chunk (after a newline or at the end of the file).
+        chunk: Receives the arcs.
+    parseDimacsChunk complexity: O(k) for k characters.
+*/
+void parseDimacsChunk(const char* begin, const char* end, ParsedChunk& chunk) {
+    chunk.nodeCount = 0;
+    const char* p = begin;
+    while (p < end) {
+        const char* lineEnd = (const char*)memchr(p, '\n', end - p);
+        if (lineEnd == NULL) {
+            lineEnd = end;
+        }
+        if (*p == 'a') {
+            p++;
+            long long fromNode = parseNumber(p, end);
+            long long toNode = parseNumber(p, end);
+            long long edgeWeight;
+            bool weightFits = parseBoundedNumber(p, end, INF - 1, edgeWeight);
+            if (fromNode >= NODE_ID_LIMIT || toNode >= NODE_ID_LIMIT) {
+                chunk.error = "Node id too large in line: " + std::string(begin, lineEnd);
+                return;
+            }
+            if (!weightFits) {
+                chunk.error = "Weight too large in line: " + std::string(begin, lineEnd);
+                return;
+            }
+            chunk.nodeCount = std::max(chunk.nodeCount, (int)std::max(fromNode, toNode) + 1);
+            chunk.arcFrom.push_back(fromNode);
+            chunk.arcTo.push_back(toNode);
+            chunk.arcWeight.push_back(edgeWeight);
+        } else if (*p == 'p') {
+            while (p < lineEnd && (*p < '0' || *p > '9')) {
+                p++;
+            }
+            long long nodes = parseNumber(p, end);
+            if (nodes >= NODE_ID_LIMIT) {
+                chunk.error = "Graph too large in line: " + std::string(begin, lineEnd);
+                return;
+            }
+            chunk.nodeCount = std::max(chunk.nodeCount, (int)nodes + 1);
         }
+        p = lineEnd + 1;
+        begin = p;
     }
 }
 
 /*
-    Function: insert
-    Inserts a new node into the min-heap and maintains the heap order.
+    Function: runInParallel
+    Runs work(t) for t = 0 .. threadCount - 1 on separate threads and waits for all of them.
     Parameters:
-        node: The node to be inserted into the heap.
-    insert complexity: O(log n), where n is the number of nodes in the heap. Inserting a new node into the heap
-    requires placing the node at the end and then sifting it up to maintain heap order.
+        threadCount: Number of threads.
+        work: The function to run.
+    runInParallel complexity: The cost of the slowest call.
 */
-void insert(int node) {
-    heapSize++;
-    heap[heapSize] = node;
-    heapPos[node] = heapSize;
-    siftUp(heapSize);
+void runInParallel(int threadCount, const std::function<void(int)>& work) {
+    std::vector<std::thread> workers;
+    for (int t = 1; t < threadCount; t++) {
+        workers.push_back(std::thread(work, t));
+    }
+    work(0);
+    for (size_t i = 0; i < workers.size(); i++) {
+        workers[i].join();
+    }
 }
 
 /*
-    Function: extractMin
-    Extracts the node with the minimum distance from the heap.
+    Function: loadGraphParallel
+    Loads a DIMACS text file by mapping it into memory and splitting it into one newline-aligned chunk
+    per thread. Threads parse their chunks into private arc buffers and count private out-degrees; the
+    degrees are then summed into the CSR offsets with a prefix sum that also gives every thread its own
+    insertion cursor per node, so the threads scatter their arcs without synchronisation and the arc
+    order matches the sequential loader.
+    Parameters:
+        path: The DIMACS file.
+        fd: Open descriptor of the file.
+        fileSize: Size of the file in bytes.
+        threadCount: Number of threads.
     Returns:
-        The node with the minimum distance from the heap.
-    extractMin complexity: O(log n), where n is the number of nodes in the heap. Extracting the minimum node from
-    the heap requires removing the root and sifting down the new root to restore the heap property.
+        The loaded graph.
+    loadGraphParallel complexity: O((n * p + m log d) / p) per thread plus O(n * p) for the prefix sum.
 */
-int extractMin() {
-    int minNode = heap[1];
-    heap[1] = heap[heapSize];
-    heapPos[heap[1]] = 1;
-    heapSize--;
-    siftDown(1);
-    return minNode;
+Graph loadGraphParallel(const char* path, int fd, size_t fileSize, int threadCount) {
+    if (fileSize == 0) {
+        std::istringstream empty("");
+        return loadGraph(empty);
+    }
+    void* mapping = mmap(NULL, fileSize, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (mapping == MAP_FAILED) {
+        throw std::runtime_error(std::string("Cannot map graph file: ") + path);
+    }
+    madvise(mapping, fileSize, MADV_SEQUENTIAL);
+    const char* text = (const char*)mapping;
+
+    // Chunk boundaries, moved forward to the start of the next line
+    std::vector<size_t> bounds(threadCount + 1);
+    bounds[0] = 0;
+    bounds[threadCount] = fileSize;
+    for (int t = 1; t < threadCount; t++) {
+        size_t pos = std::max(bounds[t - 1], fileSize / threadCount * t);
+        while (pos < fileSize && pos > 0 && text[pos - 1] != '\n') {
+            pos++;
+        }
+        bounds[t] = pos;
+    }
+
+    std::vector<ParsedChunk> chunks(threadCount);
+    runInParallel(threadCount, [&](int t) {
+        parseDimacsChunk(text + bounds[t], text + bounds[t + 1], chunks[t]);
+    });
+    munmap(mapping, fileSize);
+
+    int nodeCount = 0;
+    size_t arcCount = 0;
+    for (int t = 0; t < threadCount; t++) {
+        if (!chunks[t].error.empty()) {
+            throw std::runtime_error(chunks[t].error);
+        }
+        nodeCount = std::max(nodeCount, chunks[t].nodeCount);
+        arcCount += chunks[t].arcFrom.size();
+    }
+    if (arcCount > (size_t)INT_MAX) {
+        throw std::runtime_error("Graph too large: " + std::to_string(arcCount) + " arcs in " + path);
+    }
+
+    runInParallel(threadCount, [&](int t) {
+        ParsedChunk& chunk = chunks[t];
+        chunk.degree.assign(nodeCount, 0);
+        for (size_t i = 0; i < chunk.arcFrom.size(); i++) {
+            chunk.degree[chunk.arcFrom[i]]++;
+        }
+    });
+
+    Graph result;
+    result.mapping = NULL;
+    result.mappingSize = 0;
+    result.nodeCount = nodeCount;
+    result.arcCount = arcCount;
+    result.offsets = new int[nodeCount + 1];
+    result.arcs = new Arc[arcCount];
+
+    // Prefix sum over nodes and, within a node, over threads; degree[] becomes each thread's cursor
+    result.offsets[0] = 0;
+    for (int u = 0; u < nodeCount; u++) {
+        int pos = result.offsets[u];
+        for (int t = 0; t < threadCount; t++) {
+            int count = chunks[t].degree[u];
+            chunks[t].degree[u] = pos;
+            pos += count;
+        }
+        result.offsets[u + 1] = pos;
+    }
+
+    runInParallel(threadCount, [&](int t) {
+        ParsedChunk& chunk = chunks[t];
+        for (size_t i = 0; i < chunk.arcFrom.size(); i++) {
+            int pos = chunk.degree[chunk.arcFrom[i]]++;
+            result.arcs[pos].target = chunk.arcTo[i];
+            result.arcs[pos].weight = chunk.arcWeight[i];
+        }
+        std::vector<int>().swap(chunk.arcFrom);
+        std::vector<int>().swap(chunk.arcTo);
+        std::vector<int>().swap(chunk.arcWeight);
+    });
+
+    runInParallel(threadCount, [&](int t) {
+        sortArcSlices(result, (long long)nodeCount * t / threadCount, (long long)nodeCount * (t + 1) / threadCount);
+    });
+    return result;
 }
 
 /*
-    Complexity of main: O((n + m) log n), where n is the number of nodes and m is the number of edges.
-    The adjacency list initialization takes O(n). For Dijkstra's algorithm, the min-heap operations (insertion,
-    extraction) and edge relaxation are performed for each edge, leading to a complexity of O((n + m) log n).
-    This ensures an efficient computation of the shortest paths in sparse graphs.
+    Function: freeGraph
+    Releases the arrays of a CSR graph, unmapping them if they come from a binary graph file.
+    Parameters:
+        g: The graph to release.
+    freeGraph complexity: O(1).
 */
-int main() {
-    std::ifstream inFile("/dev/stdin");  // Input file containing the graph data
-    std::ofstream outFile("output.txt"); // Output file for results
-
-    // Initialize the adjacency list (graph) with null pointers
-    for (int i = 0; i < NODES_MAX; i++) {
-        adj[i] = NULL;
+template <class W>
+void freeGraph(BasicGraph<W>& g) {
+    if (g.mapping != NULL) {
+        munmap(g.mapping, g.mappingSize);
+    } else {
+        delete[] g.offsets;
+        delete[] g.arcs;
     }
+    g.offsets = NULL;
+    g.arcs = NULL;
+    g.mapping = NULL;
+    g.mappingSize = 0;
+    g.nodeCount = 0;
+    g.arcCount = 0;
+}
 
-    // Read the input graph data from the file
-    char buffer[256];
-    while (inFile.getline(buffer, 256)) {
-        bool processLine = true;
-        
-        if (buffer[0] == 'c') {
-            // Skip comment lines
-            processLine = false;
-        } else if (buffer[0] == 'p') {
-            // Skip problem description lines (not needed for this implementation)
-            processLine = false;
+/*
+    Function: graphChecksum
+    Computes the FNV-1a hash of the CSR arrays, one 32-bit word at a time.
+    Parameters:
+        g: The graph to hash.
+    Returns:
+        The 64-bit checksum stored in the binary graph header.
+    graphChecksum complexity: O(n + m).
+*/
+uint64_t graphChecksum(const Graph& g) {
+    uint64_t hash = 14695981039346656037ULL;
+    const int* arrays[2] = {g.offsets, (const int*)g.arcs};
+    long long lengths[2] = {(long long)g.nodeCount + 1, 2LL * g.arcCount};
+    for (int a = 0; a < 2; a++) {
+        for (long long i = 0; i < lengths[a]; i++) {
+            hash = (hash ^ (uint32_t)arrays[a][i]) * 1099511628211ULL;
         }
+    }
+    return hash;
+}
 
-        if (processLine && buffer[0] == 'a') {
-            // Process arc lines that define edges in the graph
-            int idx = 1;
-            int fromNode = parseInt(buffer, idx);  // Source node
-            int toNode = parseInt(buffer, idx);    // Destination node
-            int edgeWeight = parseInt(buffer, idx); // Weight of the edge
+/*
+    Function: saveGraphBinary
+    Writes a CSR graph to a binary graph file that loadGraphFile can map directly into memory.
+    Parameters:
+        g: The graph to save.
+        path: Destination file.
+    saveGraphBinary complexity: O(n + m).
+*/
+void saveGraphBinary(const Graph& g, const char* path) {
+    std::ofstream out(path, std::ios::binary);
+    if (!out) {
+        throw std::runtime_error(std::string("Cannot open graph file for writing: ") + path);
+    }
+    GraphFileHeader header;
+    header.magic = GRAPH_FILE_MAGIC;
+    header.version = GRAPH_FILE_VERSION;
+    header.nodeCount = g.nodeCount;
+    header.arcCount = g.arcCount;
+    header.checksum = graphChecksum(g);
+    out.write((const char*)&header, sizeof(header));
+    out.write((const char*)g.offsets, ((size_t)g.nodeCount + 1) * sizeof(int));
+    out.write((const char*)g.arcs, (size_t)g.arcCount * sizeof(Arc));
+    if (!out) {
+        throw std::runtime_error(std::string("Failed to write graph file: ") + path);
+    }
+}
 
-            // Add edge from fromNode to toNode in the adjacency list
-            Edge* edge = new Edge;
-            edge->to = toNode;
-            edge->weight = edgeWeight;
-            edge->next = adj[fromNode];
-            adj[fromNode] = edge;
+/*
+    Function: loadGraphFile
+    Loads a graph from a file. Binary graph files are mapped read-only into memory, so startup does not
+    depend on the graph size and concurrent processes share the same page cache; any other file is parsed
+    as DIMACS text with loadGraphParallel.
+    Parameters:
+        path: The graph file.
+        verify: When true the checksum of a binary file is recomputed and compared with its header.
+        threadCount: Number of threads used to parse a text file.
+    Returns:
+        The loaded graph.
+    loadGraphFile complexity: O(1) for binary files (O(n + m) with verification), O(n + m log d) for text.
+*/
+Graph loadGraphFile(const char* path, bool verify, int threadCount) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error(std::string("Cannot open graph file: ") + path);
+    }
+    struct stat fileInfo;
+    GraphFileHeader header;
+    bool isBinary = fstat(fd, &fileInfo) == 0 && (size_t)fileInfo.st_size >= sizeof(header) &&
+                    pread(fd, &header, sizeof(header), 0) == (ssize_t)sizeof(header) &&
+                    header.magic == GRAPH_FILE_MAGIC;
+    if (!isBinary) {
+        try {
+            Graph result = loadGraphParallel(path, fd, fileInfo.st_size, threadCount);
+            close(fd);
+            return result;
+        } catch (...) {
+            close(fd);
+            throw;
         }
     }
 
-    // Initialize the distance and visited arrays
-    for (int i = 0; i < NODES_MAX; i++) {
-        dist[i] = INF;
-        visited[i] = false;
-        heapPos[i] = -1;
+    if (header.version != GRAPH_FILE_VERSION || header.nodeCount > (uint32_t)INT_MAX - 1 || header.arcCount > (uint32_t)INT_MAX) {
+        close(fd);
+        throw std::runtime_error(std::string("Unsupported binary graph file (convert it again): ") + path);
+    }
+    size_t expected = sizeof(header) + ((size_t)header.nodeCount + 1) * sizeof(int) + (size_t)header.arcCount * sizeof(Arc);
+    if ((size_t)fileInfo.st_size != expected) {
+        close(fd);
+        throw std::runtime_error(std::string("Truncated binary graph file: ") + path);
     }
 
-    int startNode = 7;  // Starting node for Dijkstra's algorithm
-    dist[startNode] = 0;
-    heapSize = 0;
-    insert(startNode);
+    void* mapping = mmap(NULL, expected, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        throw std::runtime_error(std::string("Cannot map graph file: ") + path);
+    }
 
-    // Dijkstra's algorithm: process nodes to find shortest paths
-    while (heapSize > 0) {
-        int u = extractMin();  // Get the node with the minimum distance
-        if (!visited[u]) {
-            visited[u] = true;
+    Graph result;
+    result.nodeCount = header.nodeCount;
+    result.arcCount = header.arcCount;
+    result.offsets = (int*)((char*)mapping + sizeof(header));
+    result.arcs = (Arc*)(result.offsets + header.nodeCount + 1);
+    result.mapping = mapping;
+    result.mappingSize = expected;
 
-            // Relaxation step: update distances to adjacent nodes
-            Edge* edge = adj[u];
-            while (edge != NULL) {
-                int v = edge->to;
-                int weight = edge->weight;
-                if (dist[u] + weight < dist[v]) {
-                    dist[v] = dist[u] + weight;
-                    if (heapPos[v] == -1) {
-                        insert(v);
-                    } else {
-                        siftUp(heapPos[v]);
-                    }
+    if (verify && graphChecksum(result) != header.checksum) {
+        freeGraph(result);
+        throw std::runtime_error(std::string("Checksum mismatch in binary graph file: ") + path);
+    }
+    return result;
+}
+
+/*
+    Function: buildReverseGraph
+    Builds the CSR graph with every arc reversed, so that searches on it compute distances to a node.
+    Parameters:
+        g: The graph to reverse.
+    Returns:
+        The reverse graph (heap allocated; release it with freeGraph).
+    buildReverseGraph complexity: O(n + m).
+*/
+Graph buildReverseGraph(const Graph& g) {
+    Graph reverse;
+    reverse.nodeCount = g.nodeCount;
+    reverse.arcCount = g.arcCount;
+    reverse.offsets = new int[g.nodeCount + 1]();
+    reverse.arcs = new Arc[g.arcCount];
+    reverse.mapping = NULL;
+    reverse.mappingSize = 0;
+
+    for (int i = 0; i < g.arcCount; i++) {
+        reverse.offsets[g.arcs[i].target + 1]++;
+    }
+    for (int v = 0; v < g.nodeCount; v++) {
+        reverse.offsets[v + 1] += reverse.offsets[v];
+    }
+    std::vector<int> cursor(reverse.offsets, reverse.offsets + g.nodeCount);
+    for (int u = 0; u < g.nodeCount; u++) {
+        for (int i = g.offsets[u]; i < g.offsets[u + 1]; i++) {
+            int pos = cursor[g.arcs[i].target]++;
+            reverse.arcs[pos].target = u;  // Tails are visited in increasing order, so slices stay sorted
+            reverse.arcs[pos].weight = g.arcs[i].weight;
+        }
+    }
+    return reverse;
+}
+
+/*
+    Node reordering
+    Node ids of the input follow the order of the file, so the neighbours of a node are usually far away in
+    offsets[], dist[] and heapPos[]. With --reorder the graph is renumbered after loading so that nodes close
+    in the graph get close ids: in breadth-first order, in reverse Cuthill-McKee order (breadth-first from a
+    peripheral node, visiting neighbours by increasing degree, then reversed), or by recursive bisection into
+    breadth-first grown halves, which keeps every region of the graph in a contiguous id range. Searches run
+    on the internal ids; node ids are translated at the boundaries (queries, start nodes and printed results),
+    so the output is the same as without reordering.
+*/
+
+// Node orders selected with --reorder
+enum NodeOrder {
+    ORDER_NONE,
+    ORDER_BFS,         // Breadth-first order of every connected component
+    ORDER_RCM,         // Reverse Cuthill-McKee
+    ORDER_PARTITION    // Recursive bisection into breadth-first grown halves
+};
+
+#define PARTITION_LEAF_SIZE 256   // Ranges up to this size keep their breadth-first order
+
+std::vector<int> internalId;   // Internal id of every original node id after --reorder, empty otherwise
+std::vector<int> originalId;   // Original id of every internal node id
+
+/*
+    Function: toInternal
+    Translates an original node id into the id used by the reordered graph.
+    Parameters:
+        node: The original id.
+    Returns:
+        The internal id; ids outside the graph and all ids without reordering are unchanged.
+    toInternal complexity: O(1).
+*/
+inline int toInternal(int node) {
+    return node < 0 || node >= (int)internalId.size() ? node : internalId[node];
+}
+
+/*
+    Function: toOriginal
+    Translates an internal node id back into the id of the input.
+    Parameters:
+        node: The internal id.
+    Returns:
+        The original id; ids outside the graph (and -1) and all ids without reordering are unchanged.
+    toOriginal complexity: O(1).
+*/
+inline int toOriginal(int node) {
+    return node < 0 || node >= (int)originalId.size() ? node : originalId[node];
+}
+
+/*
+    Function: breadthFirstOrder
+    Appends to order the nodes of one part reachable from a root, in breadth-first order and ignoring
+    arc directions.
+    Parameters:
+        g: The graph.
+        rev: Its reverse graph.
+        root: The start node, which must belong to the part.
+        label: Part of every node; only nodes whose label equals part are visited.
+        part: The part to explore.
+        seen: Round in which every node was last reached.
+        round: Number of this search, different from every earlier one.
+        byDegree: When true the new neighbours of a node are appended by increasing degree (Cuthill-McKee).
+        order: Receives the visited nodes.
+    Returns:
+        The last node visited, which lies on the deepest level.
+    breadthFirstOrder complexity: O(k + a log a) for k visited nodes and a arcs around them.
+*/
+int breadthFirstOrder(const Graph& g, const Graph& rev, int root, const std::vector<int>& label, int part,
+                      std::vector<int>& seen, int round, bool byDegree, std::vector<int>& order) {
+    size_t head = order.size();
+    order.push_back(root);
+    seen[root] = round;
+    std::vector<std::pair<int, int> > next;
+    while (head < order.size()) {
+        int u = order[head++];
+        next.clear();
+        for (int side = 0; side < 2; side++) {
+            const Graph& adjacent = side == 0 ? g : rev;
+            for (int i = adjacent.offsets[u]; i < adjacent.offsets[u + 1]; i++) {
+                int v = adjacent.arcs[i].target;
+                if (seen[v] != round && label[v] == part) {
+                    seen[v] = round;
+                    int degree = g.offsets[v + 1] - g.offsets[v] + rev.offsets[v + 1] - rev.offsets[v];
+                    next.push_back(std::make_pair(byDegree ? degree : 0, v));
                 }
-                edge = edge->next;
             }
         }
+        if (byDegree) {
+            std::sort(next.begin(), next.end());
+        }
+        for (size_t k = 0; k < next.size(); k++) {
+            order.push_back(next[k].second);
+        }
+    }
+    return order.back();
+}
+
+/*
+    Function: computeNodeOrder
+    Computes a locality preserving order of the nodes of a graph.
+    Parameters:
+        g: The graph.
+        kind: The order to compute.
+    Returns:
+        The nodes in their new order: the node at position k gets internal id k.
+    computeNodeOrder complexity: O(n + m log d) for ORDER_BFS and ORDER_RCM, O((n + m) log n) for ORDER_PARTITION.
+*/
+std::vector<int> computeNodeOrder(const Graph& g, NodeOrder kind) {
+    Graph rev = buildReverseGraph(g);
+    int n = g.nodeCount;
+    std::vector<int> label(n, 0);
+    std::vector<int> seen(n, 0);
+    std::vector<int> order;
+    order.reserve(n);
+
+    // Every connected component in breadth-first order (round 1). RCM starts it from the last node of a
+    // first sweep (round 2, undone afterwards), which lies on the periphery of the component
+    std::vector<int> sweep;
+    for (int v = 0; v < n; v++) {
+        if (seen[v] == 1) {
+            continue;
+        }
+        int root = v;
+        if (kind == ORDER_RCM) {
+            sweep.clear();
+            root = breadthFirstOrder(g, rev, v, label, 0, seen, 2, false, sweep);
+            for (size_t k = 0; k < sweep.size(); k++) {
+                seen[sweep[k]] = 0;
+            }
+        }
+        breadthFirstOrder(g, rev, root, label, 0, seen, 1, kind == ORDER_RCM, order);
+    }
+    int round = 2;
+    if (kind == ORDER_RCM) {
+        std::reverse(order.begin(), order.end());
     }
 
-    // Output the shortest distances from the start node to all other nodes
-    for (int i = 1; i < NODES_MAX; i++) {
-        if (dist[i] < INF) {
-            std::cout << "Node " << startNode << " to Node " << i << " : " << dist[i] << std::endl;
-            outFile << "Node " << startNode << " to Node " << i << " : " << dist[i] << std::endl;
-        } else {
-            std::cout << "Node " << startNode << " to Node " << i << " : Unreachable" << std::endl;
-            outFile << "Node " << startNode << " to Node " << i << " : Unreachable" << std::endl;
+    if (kind == ORDER_PARTITION) {
+        // Split ranges of the order in two halves grown breadth-first from a peripheral node of the range
+        std::vector<std::pair<int, int> > ranges;
+        ranges.push_back(std::make_pair(0, n));
+        std::vector<int> grown;
+        int part = 0;
+        while (!ranges.empty()) {
+            int begin = ranges.back().first;
+            int end = ranges.back().second;
+            ranges.pop_back();
+            if (end - begin <= PARTITION_LEAF_SIZE) {
+                continue;
+            }
+            part++;
+            for (int k = begin; k < end; k++) {
+                label[order[k]] = part;
+            }
+            grown.clear();
+            int peripheral = breadthFirstOrder(g, rev, order[begin], label, part, seen, ++round, false, grown);
+            grown.clear();
+            breadthFirstOrder(g, rev, peripheral, label, part, seen, ++round, false, grown);
+            for (int k = begin; k < end && (int)grown.size() < end - begin; k++) {
+                if (seen[order[k]] != round) {
+                    // Another component of the range: continue growing from it
+                    breadthFirstOrder(g, rev, order[k], label, part, seen, round, false, grown);
+                }
+            }
+            std::copy(grown.begin(), grown.end(), order.begin() + begin);
+            int middle = begin + (end - begin) / 2;
+            ranges.push_back(std::make_pair(begin, middle));
+            ranges.push_back(std::make_pair(middle, end));
         }
     }
+    freeGraph(rev);
+    return order;
+}
 
-    // Free dynamically allocated memory for the adjacency list
-    for (int i = 0; i < NODES_MAX; i++) {
-        Edge* edge = adj[i];
-        while (edge != NULL) {
-            Edge* temp = edge;
-            edge = edge->next;
-            delete temp;
+/*
+    Function: permuteGraph
+    Builds the graph with renumbered nodes.
+    Parameters:
+        g: The graph.
+        order: The nodes in their new order, as returned by computeNodeOrder.
+    Returns:
+        The renumbered graph (heap allocated; release it with freeGraph).
+    permuteGraph complexity: O(n + m log d).
+*/
+Graph permuteGraph(const Graph& g, const std::vector<int>& order) {
+    std::vector<int> newId(g.nodeCount);
+    for (int k = 0; k < g.nodeCount; k++) {
+        newId[order[k]] = k;
+    }
+    Graph result;
+    result.mapping = NULL;
+    result.mappingSize = 0;
+    result.nodeCount = g.nodeCount;
+    result.arcCount = g.arcCount;
+    result.offsets = new int[g.nodeCount + 1];
+    result.arcs = new Arc[g.arcCount];
+    result.offsets[0] = 0;
+    for (int k = 0; k < g.nodeCount; k++) {
+        int u = order[k];
+        int pos = result.offsets[k];
+        for (int i = g.offsets[u]; i < g.offsets[u + 1]; i++) {
+            result.arcs[pos].target = newId[g.arcs[i].target];
+            result.arcs[pos].weight = g.arcs[i].weight;
+            pos++;
         }
+        result.offsets[k + 1] = pos;
+    }
+    sortArcSlices(result, 0, result.nodeCount);
+    return result;
+}
+
+/*
+    Function: reorderGraph
+    Replaces the global graph by its renumbered copy and records the translation of node ids.
+    Parameters:
+        kind: The order to apply.
+    reorderGraph complexity: See computeNodeOrder.
+*/
+void reorderGraph(NodeOrder kind) {
+    std::vector<int> order = computeNodeOrder(graph, kind);
+    Graph reordered = permuteGraph(graph, order);
+    freeGraph(graph);
+    graph = reordered;
+    originalId = order;
+    internalId.assign(graph.nodeCount, 0);
+    for (int k = 0; k < graph.nodeCount; k++) {
+        internalId[order[k]] = k;
     }
+}
 
-    // Close the output file
-    outFile.close();
+/*
+    Function: initSearchState
+    Allocates the arrays of a search state for the node slots of a graph.
+    Parameters:
+        state: The state to initialise.
+        nodeCount: Number of node slots of the graph searched.
+    initSearchState complexity: O(n), performed once per state.
+*/
+template <class W>
+void initSearchState(BasicSearchState<W>& state, int nodeCount) {
+    state.nodeCount = nodeCount;
+    state.dist = new W[nodeCount];
+    state.heap = new int[nodeCount + 1];
+    state.heapPos = new int[nodeCount];
+    state.pred = new int[nodeCount];
+    state.stamp = new int[nodeCount]();
+    state.heapSize = 0;
+    state.round = 0;
+    state.radixHeap.last = 0;
+    state.radixHeap.count = 0;
+    state.bucketQueue.current = 0;
+    state.bucketQueue.count = 0;
+    memset(&state.counters, 0, sizeof(state.counters));
+}
+
+/*
+    Function: freeSearchState
+    Releases the arrays of a search state.
+    Parameters:
+        state: The state to release.
+    freeSearchState complexity: O(1).
+*/
+template <class W>
+void freeSearchState(BasicSearchState<W>& state) {
+    delete[] state.dist;
+    delete[] state.heap;
+    delete[] state.heapPos;
+    delete[] state.pred;
+    delete[] state.stamp;
+}
+
+/*
+    Function: beginSearch
+    Starts a new search on a state by advancing its round; all nodes become untouched in O(1).
+    The stamps are only cleared when the round counter would overflow.
+    Parameters:
+        state: The state to reset.
+    beginSearch complexity: O(1) amortized.
+*/
+template <class W>
+void beginSearch(BasicSearchState<W>& state) {
+    if (state.round == 2147483647) {
+        memset(state.stamp, 0, state.nodeCount * sizeof(int));
+        state.round = 0;
+    }
+    state.round++;
+    state.heapSize = 0;
+}
+
+/*
+    Function: touch
+    Gives a node its initial values (infinite distance, not in the heap, no predecessor) the first time
+    it is reached in the current search.
+    Parameters:
+        state: The search state.
+        node: The node being reached.
+    touch complexity: O(1).
+*/
+template <class W>
+inline void touch(BasicSearchState<W>& state, int node) {
+    if (state.stamp[node] != state.round) {
+        state.stamp[node] = state.round;
+        state.dist[node] = WeightTraits<W>::infinity();
+        state.heapPos[node] = -1;
+        state.pred[node] = -1;
+    }
+}
+
+/*
+    Function: searchDistance
+    Reads the distance of a node computed by the current search.
+    Parameters:
+        state: The search state.
+        node: The node to look up.
+    Returns:
+        The distance of node, or the infinity of its weight type (INF for int) if it was not reached.
+    searchDistance complexity: O(1).
+*/
+template <class W>
+inline W searchDistance(const BasicSearchState<W>& state, int node) {
+    if (node < 0 || node >= state.nodeCount || state.stamp[node] != state.round) {
+        return WeightTraits<W>::infinity();
+    }
+    return state.dist[node];
+}
+
+/*
+    Function: swap
+    Swaps two elements in the heap and updates their positions.
+    Parameters:
+        state: The search state owning the heap.
+        i: Index of the first element in the heap.
+        j: Index of the second element in the heap.
+    swap complexity: O(1), constant time to swap two elements in the heap and update their positions.
+*/
+template <class W>
+void swap(BasicSearchState<W>& state, int i, int j) {
+    int* heap = state.heap;
+    int temp = heap[i];
+    heap[i] = heap[j];
+    heap[j] = temp;
+    state.heapPos[heap[i]] = i;
+    state.heapPos[heap[j]] = j;
+}
+
+/*
+    Function: siftUp
+    Reorganizes the heap by moving a node upward to maintain heap order.
+    Parameters:
+        state: The search state owning the heap.
+        idx: The index of the node to be sifted up in the heap.
+    siftUp complexity: O(log n), where n is the number of nodes in the heap. The function maintains the heap order
+    by moving a node upwards, and in the worst case, it travels up the height of the heap, which is log n.
+*/
+template <class W>
+void siftUp(BasicSearchState<W>& state, int idx) {
+    const W* dist = state.dist;
+    const int* heap = state.heap;
+    while (idx > 1 && dist[heap[idx]] < dist[heap[idx / 2]]) {
+        swap(state, idx, idx / 2);
+        idx = idx / 2;
+    }
+}
+
+/*
+    Function: siftDown
+    Reorganizes the heap by moving a node downward to maintain heap order.
+    Parameters:
+        state: The search state owning the heap.
+        idx: The index of the node to be sifted down in the heap.
+    siftDown complexity: O(log n), where n is the number of nodes in the heap. This function ensures that the heap
+    order is maintained by moving a node downwards, with a worst-case time of log n, proportional to the height of the heap.
+*/
+template <class W>
+void siftDown(BasicSearchState<W>& state, int idx) {
+    const W* dist = state.dist;
+    const int* heap = state.heap;
+    int heapSize = state.heapSize;
+    while (2 * idx <= heapSize) {
+        int child = 2 * idx;
+        if (child + 1 <= heapSize && dist[heap[child + 1]] < dist[heap[child]]) {
+            child++;
+        }
+        if (dist[heap[idx]] <= dist[heap[child]]) {
+            idx = heapSize + 1;  // Exit the loop
+        } else {
+            swap(state, idx, child);
+            idx = child;
+        }
+    }
+}
+
+/*
+    Function: insert
+    Inserts a new node into the min-heap and maintains the heap order.
+    Parameters:
+        state: The search state owning the heap.
+        node: The node to be inserted into the heap.
+    insert complexity: O(log n), where n is the number of nodes in the heap. Inserting a new node into the heap
+    requires placing the node at the end and then sifting it up to maintain heap order.
+*/
+template <class W>
+void insert(BasicSearchState<W>& state, int node) {
+    state.heapSize++;
+    state.heap[state.heapSize] = node;
+    state.heapPos[node] = state.heapSize;
+    siftUp(state, state.heapSize);
+}
+
+/*
+    Function: extractMin
+    Extracts the node with the minimum distance from the heap.
+    Parameters:
+        state: The search state owning the heap.
+    Returns:
+        The node with the minimum distance from the heap.
+    extractMin complexity: O(log n), where n is the number of nodes in the heap. Extracting the minimum node from
+    the heap requires removing the root and sifting down the new root to restore the heap property.
+*/
+template <class W>
+int extractMin(BasicSearchState<W>& state) {
+    int* heap = state.heap;
+    int minNode = heap[1];
+    heap[1] = heap[state.heapSize];
+    state.heapPos[heap[1]] = 1;
+    state.heapSize--;
+    siftDown(state, 1);
+    state.heapPos[minNode] = -1;
+    return minNode;
+}
+
+/*
+    Priority queue adapters
+    Each queue offers clear(), empty(), size(), push(node, key) and pop() so that dijkstraWithQueue can be
+    instantiated for it. push is called whenever the distance of a node decreases; queues without
+    decrease-key simply store another entry, and pop may then return a node that is already visited.
+*/
+
+// The indexed binary heap of the search state; push inserts or decreases the key of a node
+template <class W>
+struct BasicBinaryHeapQueue {
+    BasicSearchState<W>& state;
+
+    explicit BasicBinaryHeapQueue(BasicSearchState<W>& s) : state(s) {}
+    void clear() { state.heapSize = 0; }
+    bool empty() const { return state.heapSize == 0; }
+    size_t size() const { return state.heapSize; }
+    void push(int node, W) {
+        if (state.heapPos[node] == -1) {
+            insert(state, node);
+        } else {
+            siftUp(state, state.heapPos[node]);
+        }
+    }
+    int pop() { return extractMin(state); }
+};
+
+typedef BasicBinaryHeapQueue<int> BinaryHeapQueue;
+
+// Radix heap adapter, for the non-negative int keys of the int instance only
+struct RadixHeapQueue {
+    RadixHeap& heap;
+
+    explicit RadixHeapQueue(RadixHeap& h) : heap(h) {}
+
+    static int bucketOf(unsigned key, unsigned last) {
+        return key == last ? 0 : 32 - __builtin_clz(key ^ last);
+    }
+
+    void clear() {
+        for (int i = 0; i < 33; i++) {
+            heap.buckets[i].clear();
+        }
+        heap.last = 0;
+        heap.count = 0;
+    }
+    bool empty() const { return heap.count == 0; }
+    size_t size() const { return heap.count; }
+    void push(int node, int key) {
+        heap.buckets[bucketOf(key, heap.last)].push_back(std::make_pair((unsigned)key, node));
+        heap.count++;
+    }
+    int pop() {
+        if (heap.buckets[0].empty()) {
+            // Refill bucket 0 from the first non-empty bucket, re-keyed around its minimum
+            int i = 1;
+            while (heap.buckets[i].empty()) {
+                i++;
+            }
+            std::vector<std::pair<unsigned, int> >& source = heap.buckets[i];
+            unsigned minKey = source[0].first;
+            for (size_t j = 1; j < source.size(); j++) {
+                minKey = std::min(minKey, source[j].first);
+            }
+            heap.last = minKey;
+            for (size_t j = 0; j < source.size(); j++) {
+                heap.buckets[bucketOf(source[j].first, minKey)].push_back(source[j]);
+            }
+            source.clear();
+        }
+        int node = heap.buckets[0].back().second;
+        heap.buckets[0].pop_back();
+        heap.count--;
+        return node;
+    }
+};
+
+// Dial bucket queue adapter, for int keys only
+struct DialQueue {
+    BucketQueue& queue;
+
+    explicit DialQueue(BucketQueue& q) : queue(q) {
+        if ((int)queue.buckets.size() != dialBucketCount) {
+            queue.buckets.assign(dialBucketCount, std::vector<int>());
+            queue.count = 0;
+        }
+    }
+
+    void clear() {
+        if (queue.count > 0) {
+            for (size_t i = 0; i < queue.buckets.size(); i++) {
+                queue.buckets[i].clear();
+            }
+        }
+        queue.current = 0;
+        queue.count = 0;
+    }
+    bool empty() const { return queue.count == 0; }
+    size_t size() const { return queue.count; }
+    void push(int node, int key) {
+        queue.buckets[key % queue.buckets.size()].push_back(node);
+        queue.count++;
+    }
+    int pop() {
+        size_t size = queue.buckets.size();
+        while (queue.buckets[queue.current % size].empty()) {
+            queue.current++;
+        }
+        std::vector<int>& bucket = queue.buckets[queue.current % size];
+        int node = bucket.back();
+        bucket.pop_back();
+        queue.count--;
+        return node;
+    }
+};
+
+// d-ary heap adapter with arity D and key type W fixed at compile time. The root is entries[0] and the children of
+// entry i are entries[D * i + 1 .. D * i + D], which share one or two cache lines for D up to 8.
+// heapPos of the search state holds the position of every queued node for decrease-key.
+template <int D, class W = int>
+struct DAryHeapQueue {
+    std::vector<BasicHeapEntry<W> >& entries;
+    int* heapPos;
+
+    explicit DAryHeapQueue(BasicSearchState<W>& state) : entries(state.dAryEntries), heapPos(state.heapPos) {}
+
+    void clear() { entries.clear(); }
+    bool empty() const { return entries.empty(); }
+    size_t size() const { return entries.size(); }
+    W topKey() const { return entries[0].key; }
+
+    // Moves the entry at idx towards the root, shifting larger parents down into the hole
+    void siftUp(int idx) {
+        BasicHeapEntry<W> moving = entries[idx];
+        while (idx > 0) {
+            int parent = (idx - 1) / D;
+            if (entries[parent].key <= moving.key) {
+                break;
+            }
+            entries[idx] = entries[parent];
+            heapPos[entries[idx].node] = idx;
+            idx = parent;
+        }
+        entries[idx] = moving;
+        heapPos[moving.node] = idx;
+    }
+
+    // Moves the entry at idx towards the leaves, pulling the smallest child up into the hole
+    void siftDown(int idx) {
+        int size = entries.size();
+        BasicHeapEntry<W> moving = entries[idx];
+        while (true) {
+            int first = D * idx + 1;
+            if (first >= size) {
+                break;
+            }
+            int last = std::min(first + D, size);
+            int best = first;
+            for (int c = first + 1; c < last; c++) {
+                if (entries[c].key < entries[best].key) {
+                    best = c;
+                }
+            }
+            if (moving.key <= entries[best].key) {
+                break;
+            }
+            entries[idx] = entries[best];
+            heapPos[entries[idx].node] = idx;
+            idx = best;
+        }
+        entries[idx] = moving;
+        heapPos[moving.node] = idx;
+    }
+
+    void push(int node, W key) {
+        if (heapPos[node] == -1) {
+            BasicHeapEntry<W> entry = {key, node};
+            entries.push_back(entry);
+            siftUp(entries.size() - 1);
+        } else {
+            entries[heapPos[node]].key = key;  // Decrease-key
+            siftUp(heapPos[node]);
+        }
+    }
+
+    int pop() {
+        int minNode = entries[0].node;
+        heapPos[minNode] = -1;  // No longer queued; the search marks it SETTLED
+        entries[0] = entries.back();
+        entries.pop_back();
+        if (!entries.empty()) {
+            siftDown(0);
+        }
+        return minNode;
+    }
+};
+
+/*
+    Function: dijkstraWithQueue
+    Runs Dijkstra's algorithm from a source node with the given priority queue, starting a new round
+    of the search state.
+    Parameters:
+        g: The graph.
+        state: The search state receiving the distances.
+        queue: The priority queue adapter.
+        source: The start node.
+        target: Node at which the search may stop once it is settled, or -1 to settle every reachable node.
+        limits: Further stopping rules, or NULL to stop only at target.
+    Returns:
+        The distance to target (the infinity of W if unreachable), or 0 when target is -1.
+    dijkstraWithQueue complexity: O((n + m) log n) with the binary heap, O(m + n log C) with the radix heap
+    and O(m + D) with Dial's queue, where C is the largest arc weight and D the largest distance. A d-ary
+    heap needs O(log n / log d) steps per decrease-key and O(d log n / log d) per extraction.
+*/
+template <class W, class Queue>
+W dijkstraWithQueue(const BasicGraph<W>& g, BasicSearchState<W>& state, Queue& queue, int source, int target,
+                    const BasicSearchLimits<W>* limits = NULL) {
+    beginSearch(state);
+    queue.clear();
+    touch(state, source);
+    state.dist[source] = 0;
+    SearchCounters& counters = state.counters;
+    if (source < g.nodeCount) {
+        queue.push(source, 0);  // A start node beyond the graph has no arcs to relax
+        counters.pushes++;
+        counters.maxQueueSize = std::max(counters.maxQueueSize, 1LL);
+    }
+
+    W* dist = state.dist;
+    int* pred = state.pred;
+    int* heapPos = state.heapPos;
+    int remainingTargets = limits != NULL ? limits->targetCount : 0;
+    int settledCount = 0;
+    while (!queue.empty()) {
+        int u = queue.pop();  // Get the node with the minimum distance
+        counters.pops++;
+        if (heapPos[u] != SETTLED) {
+            if (limits != NULL && dist[u] > limits->radius) {
+                break;  // Every node left in the queue is farther than the radius
+            }
+            heapPos[u] = SETTLED;
+            counters.settled++;
+            if (u == target) {
+                return dist[u];
+            }
+            if (limits != NULL) {
+                if (limits->settled != NULL) {
+                    limits->settled->push_back(u);
+                }
+                if ((limits->isTarget != NULL && limits->isTarget[u] && --remainingTargets == 0) ||
+                    ++settledCount == limits->maxSettled) {
+                    break;
+                }
+            }
+
+            // Relaxation step: update distances to adjacent nodes
+            int arcEnd = g.offsets[u + 1];
+            counters.relaxedArcs += arcEnd - g.offsets[u];
+            for (int i = g.offsets[u]; i < arcEnd; i++) {
+                int v = g.arcs[i].target;
+                touch(state, v);
+                W nd = WeightTraits<W>::add(dist[u], g.arcs[i].weight);
+                if (nd < dist[v]) {
+                    dist[v] = nd;
+                    pred[v] = u;
+                    if (heapPos[v] == -1) {
+                        counters.pushes++;
+                    } else {
+                        counters.decreaseKeys++;
+                    }
+                    queue.push(v, dist[v]);
+                }
+            }
+            counters.maxQueueSize = std::max(counters.maxQueueSize, (long long)queue.size());
+        }
+    }
+    return target == -1 ? W(0) : searchDistance(state, target);
+}
+
+/*
+    Function: dijkstra
+    Runs Dijkstra's algorithm with the priority queue selected by queueKind.
+    Parameters:
+        g: The graph.
+        state: The search state receiving the distances.
+        source: The start node.
+        target: Node at which the search may stop once it is settled, or -1 to settle every reachable node.
+        limits: Further stopping rules, or NULL to stop only at target.
+    Returns:
+        The distance to target (INF if unreachable), or 0 when target is -1.
+    dijkstra complexity: See dijkstraWithQueue; a point-to-point search stops after settling target.
+*/
+int dijkstra(const Graph& g, SearchState& state, int source, int target, const SearchLimits* limits = NULL) {
+    if (queueKind == QUEUE_RADIX) {
+        RadixHeapQueue queue(state.radixHeap);
+        return dijkstraWithQueue(g, state, queue, source, target, limits);
+    }
+    if (queueKind == QUEUE_DIAL) {
+        DialQueue queue(state.bucketQueue);
+        return dijkstraWithQueue(g, state, queue, source, target, limits);
+    }
+    if (queueKind == QUEUE_DARY2) {
+        DAryHeapQueue<2> queue(state);
+        return dijkstraWithQueue(g, state, queue, source, target, limits);
+    }
+    if (queueKind == QUEUE_DARY4) {
+        DAryHeapQueue<4> queue(state);
+        return dijkstraWithQueue(g, state, queue, source, target, limits);
+    }
+    if (queueKind == QUEUE_DARY8) {
+        DAryHeapQueue<8> queue(state);
+        return dijkstraWithQueue(g, state, queue, source, target, limits);
+    }
+    BinaryHeapQueue queue(state);
+    return dijkstraWithQueue(g, state, queue, source, target, limits);
+}
+
+/*
+    Function: boundedSearch
+    Runs Dijkstra from a source until a stopping rule is met: all targets settled, the next node farther
+    than a radius, or a number of nodes settled. Local queries thereby only visit the part of the graph
+    they need instead of all of it.
+    Parameters:
+        g: The graph.
+        state: The search state receiving the distances.
+        source: The start node.
+        radius: Largest distance to settle, INF for no bound.
+        nearestCount: Number of nodes to settle (the source included), 0 for no limit.
+        targets: Nodes whose settling ends the search, empty for none.
+    Returns:
+        The settled nodes in order of distance.
+    boundedSearch complexity: O(k log k + a) for k settled nodes and a arcs leaving them.
+*/
+std::vector<int> boundedSearch(const Graph& g, SearchState& state, int source, int radius, int nearestCount,
+                               const std::vector<int>& targets) {
+    std::vector<int> settled;
+    std::vector<char> isTarget;
+    SearchLimits limits = {radius, nearestCount, NULL, 0, &settled};
+    if (!targets.empty()) {
+        isTarget.assign(std::max(g.nodeCount, source + 1), 0);
+        for (size_t k = 0; k < targets.size(); k++) {
+            if (targets[k] < (int)isTarget.size() && !isTarget[targets[k]]) {
+                isTarget[targets[k]] = 1;
+                limits.targetCount++;
+            }
+        }
+        limits.isTarget = isTarget.data();
+    }
+    dijkstra(g, state, source, -1, &limits);
+    return settled;
+}
+
+/*
+    Function: extractPath
+    Follows the predecessors recorded by the last search back from a target.
+    Parameters:
+        state: The search state.
+        target: The destination node.
+    Returns:
+        The nodes of the shortest path from the source to target, empty if target was not reached.
+    extractPath complexity: O(k), where k is the number of nodes on the path.
+*/
+std::vector<int> extractPath(const SearchState& state, int target) {
+    std::vector<int> path;
+    if (searchDistance(state, target) >= INF) {
+        return path;
+    }
+    for (int v = target; v != -1; v = state.pred[v]) {
+        path.push_back(v);
+    }
+    std::reverse(path.begin(), path.end());
+    return path;
+}
+
+/*
+    Function: saveShortestPathTree
+    Writes the shortest path tree of the last search as int32 values: the source, the number of node
+    slots n, then the predecessor of every node 0 .. n - 1 (-1 for the source and unreached nodes).
+    Parameters:
+        state: The search state.
+        source: The start node of the search.
+        nodeCount: Number of node slots to write.
+        path: Destination file.
+    saveShortestPathTree complexity: O(n).
+*/
+void saveShortestPathTree(const SearchState& state, int source, int nodeCount, const char* path) {
+    std::ofstream out(path, std::ios::binary);
+    if (!out) {
+        throw std::runtime_error(std::string("Cannot open tree file for writing: ") + path);
+    }
+    std::vector<int32_t> tree(nodeCount + 2);
+    tree[0] = source;
+    tree[1] = nodeCount;
+    for (int v = 0; v < nodeCount; v++) {
+        int u = toInternal(v);
+        tree[v + 2] = searchDistance(state, u) < INF ? toOriginal(state.pred[u]) : -1;
+    }
+    out.write((const char*)tree.data(), tree.size() * sizeof(int32_t));
+    if (!out) {
+        throw std::runtime_error(std::string("Failed to write tree file: ") + path);
+    }
+}
+
+/*
+    Function: bidirectionalDijkstra
+    Answers a point-to-point query by running Dijkstra forward from the source on the graph and backward
+    from the target on the reverse graph, always advancing the direction with the smaller queue key.
+    Every relaxed arc that reaches a node already labelled by the other direction gives a candidate
+    s-t distance; the search stops once the two smallest queue keys add up to at least the best candidate,
+    because no unexplored path can be shorter.
+    Parameters:
+        g: The graph.
+        reverse: The reverse graph of g.
+        forward: Search state of the forward direction.
+        backward: Search state of the backward direction.
+        source: The start node.
+        target: The destination node.
+        meeting: Receives a node on the shortest path where both searches meet, -1 if unreachable.
+    Returns:
+        The distance from source to target, or INF if unreachable.
+    bidirectionalDijkstra complexity: O((n + m) log n) in the worst case; on road graphs each direction
+    typically explores about half the ball a unidirectional search would.
+*/
+int bidirectionalDijkstra(const Graph& g, const Graph& reverse, SearchState& forward, SearchState& backward,
+                          int source, int target, int& meeting) {
+    beginSearch(forward);
+    beginSearch(backward);
+    DAryHeapQueue<4> forwardQueue(forward);
+    DAryHeapQueue<4> backwardQueue(backward);
+    forwardQueue.clear();
+    backwardQueue.clear();
+
+    touch(forward, source);
+    forward.dist[source] = 0;
+    touch(backward, target);
+    backward.dist[target] = 0;
+    meeting = -1;
+    int best = INF;
+    if (source == target) {
+        meeting = source;
+        return 0;
+    }
+    if (source < g.nodeCount && target < g.nodeCount) {
+        forwardQueue.push(source, 0);
+        backwardQueue.push(target, 0);
+    }
+
+    while (!forwardQueue.empty() && !backwardQueue.empty() &&
+           forwardQueue.topKey() + backwardQueue.topKey() < best) {
+        bool forwardTurn = forwardQueue.topKey() <= backwardQueue.topKey();
+        const Graph& side = forwardTurn ? g : reverse;
+        SearchState& mine = forwardTurn ? forward : backward;
+        SearchState& other = forwardTurn ? backward : forward;
+        DAryHeapQueue<4>& queue = forwardTurn ? forwardQueue : backwardQueue;
+
+        int u = queue.pop();
+        mine.heapPos[u] = SETTLED;
+        int du = mine.dist[u];
+        for (int i = side.offsets[u]; i < side.offsets[u + 1]; i++) {
+            int v = side.arcs[i].target;
+            int nd = du + side.arcs[i].weight;
+            touch(mine, v);
+            if (nd < mine.dist[v]) {
+                mine.dist[v] = nd;
+                mine.pred[v] = u;
+                queue.push(v, nd);
+            }
+            int dv = searchDistance(other, v);
+            if (dv < INF && nd + dv < best) {
+                best = nd + dv;
+                meeting = v;
+            }
+        }
+    }
+    return best;
+}
+
+/*
+    Function: extractBidirectionalPath
+    Joins the forward predecessors from the meeting node back to the source with the backward
+    predecessors (successors in the graph) from the meeting node on to the target.
+    Parameters:
+        forward: Search state of the forward direction.
+        backward: Search state of the backward direction.
+        meeting: The meeting node reported by bidirectionalDijkstra, -1 if unreachable.
+    Returns:
+        The nodes of the shortest path, empty if unreachable.
+    extractBidirectionalPath complexity: O(k) for a path of k nodes.
+*/
+std::vector<int> extractBidirectionalPath(const SearchState& forward, const SearchState& backward, int meeting) {
+    std::vector<int> path;
+    if (meeting == -1) {
+        return path;
+    }
+    path = extractPath(forward, meeting);
+    for (int v = backward.pred[meeting]; v != -1; v = backward.pred[v]) {
+        path.push_back(v);
+    }
+    return path;
+}
+
+/*
+    Function: pointToPoint
+    Answers a point-to-point query with the bidirectional search when it is enabled, otherwise with a
+    Dijkstra that stops once the target is settled.
+    Parameters:
+        forward: Search state of the (forward) search.
+        backward: Search state of the backward direction, unused for unidirectional queries.
+        source: The start node.
+        target: The destination node.
+        path: Receives the node sequence of the path when not NULL.
+    Returns:
+        The distance from source to target, or INF if unreachable.
+    pointToPoint complexity: O((n + m) log n) in the worst case.
+*/
+int pointToPoint(SearchState& forward, SearchState& backward, int source, int target, std::vector<int>* path) {
+    source = toInternal(source);
+    target = toInternal(target);
+    int d;
+    if (bidirectionalQueries) {
+        int meeting;
+        d = bidirectionalDijkstra(graph, reverseGraph, forward, backward, source, target, meeting);
+        if (path != NULL) {
+            *path = extractBidirectionalPath(forward, backward, meeting);
+        }
+    } else {
+        d = dijkstra(graph, forward, source, target);
+        if (path != NULL) {
+            *path = extractPath(forward, target);
+        }
+    }
+    if (path != NULL) {
+        for (size_t k = 0; k < path->size(); k++) {
+            (*path)[k] = toOriginal((*path)[k]);
+        }
+    }
+    return d;
+}
+
+/*
+    Function: maxArcWeight
+    Finds the largest arc weight of a graph.
+    Parameters:
+        g: The graph.
+    Returns:
+        The largest weight, 0 for a graph without arcs.
+    maxArcWeight complexity: O(m).
+*/
+int maxArcWeight(const Graph& g) {
+    int result = 0;
+    for (int i = 0; i < g.arcCount; i++) {
+        result = std::max(result, g.arcs[i].weight);
+    }
+    return result;
+}
+
+/*
+    Dynamic arc weights
+    Arc weights of the loaded graph can be changed in place (a memory mapped graph is copied to the heap
+    first), and a shortest path tree computed before the change is repaired incrementally in the style
+    of Ramalingam and Reps. A decrease of arc (u, v) can only shorten paths through v, so a Dijkstra is
+    seeded with v alone and stops wherever distances no longer improve. An increase can only lengthen
+    paths of the subtree hanging below v, and only if the arc is the tree arc of v; that subtree is
+    detached, each of its nodes takes the best incoming arc from outside it (found in the reverse graph),
+    and a Dijkstra restricted to the subtree settles the rest. Repairs that touch too many nodes fall
+    back to a full search, which is then cheaper.
+*/
+
+// A new weight for the arc from -> to
+struct ArcUpdate {
+    int from;
+    int to;
+    int weight;
+};
+
+// Scratch space and statistics of the incremental repairs of one shortest path tree
+struct TreeRepair {
+    std::vector<int> affected;      // Detached subtree of an increase
+    std::vector<char> isAffected;   // Membership flags of affected, one per node slot
+    int touchLimit;                 // Nodes a repair may settle before it falls back to a full search
+    long long repairs;              // Updates handled incrementally
+    long long recomputations;       // Updates that fell back to a full search
+    long long settledNodes;         // Nodes settled by all incremental repairs
+};
+
+/*
+    Function: findArc
+    Looks up an arc with binary search in the slice of its tail, which is sorted by head.
+    Parameters:
+        g: The graph.
+        from: Tail of the arc.
+        to: Head of the arc.
+    Returns:
+        The index of the first arc from -> to, or -1 if there is none.
+    findArc complexity: O(log d).
+*/
+int findArc(const Graph& g, int from, int to) {
+    if (from < 0 || from >= g.nodeCount) {
+        return -1;
+    }
+    const Arc* begin = g.arcs + g.offsets[from];
+    const Arc* end = g.arcs + g.offsets[from + 1];
+    Arc key = {to, -1};
+    const Arc* arc = std::lower_bound(begin, end, key, arcLess<int>);
+    return arc != end && arc->target == to ? arc - g.arcs : -1;
+}
+
+/*
+    Function: makeGraphWritable
+    Copies the arrays of a memory mapped graph to the heap and releases the read-only mapping, so its
+    weights can be modified. Heap allocated graphs are left untouched.
+    Parameters:
+        g: The graph.
+    makeGraphWritable complexity: O(n + m) for a mapped graph, O(1) otherwise.
+*/
+void makeGraphWritable(Graph& g) {
+    if (g.mapping == NULL) {
+        return;
+    }
+    int* offsets = new int[g.nodeCount + 1];
+    Arc* arcs = new Arc[g.arcCount];
+    memcpy(offsets, g.offsets, (g.nodeCount + 1) * sizeof(int));
+    memcpy(arcs, g.arcs, g.arcCount * sizeof(Arc));
+    munmap(g.mapping, g.mappingSize);
+    g.offsets = offsets;
+    g.arcs = arcs;
+    g.mapping = NULL;
+    g.mappingSize = 0;
+}
+
+/*
+    Function: setArcWeight
+    Changes the weight of an arc in a graph and, if it has been built, in its reverse graph.
+    Parameters:
+        g: The graph, which must be heap allocated (see makeGraphWritable).
+        rev: The reverse graph, or an empty graph.
+        from: Tail of the arc.
+        to: Head of the arc.
+        weight: The new weight.
+    Returns:
+        The previous weight of the arc.
+    setArcWeight complexity: O(log d).
+*/
+int setArcWeight(Graph& g, Graph& rev, int from, int to, int weight) {
+    int arc = findArc(g, from, to);
+    if (arc == -1) {
+        throw std::runtime_error("No arc from " + std::to_string(from) + " to " + std::to_string(to));
+    }
+    int previous = g.arcs[arc].weight;
+    g.arcs[arc].weight = weight;
+    if (rev.offsets != NULL) {
+        // Parallel arcs keep their relative order in the reverse graph, so the first ones correspond
+        rev.arcs[findArc(rev, to, from)].weight = weight;
+    }
+    return previous;
+}
+
+/*
+    Function: readArcUpdates
+    Reads weight updates "u v w" from a file, one per line.
+    Parameters:
+        path: The file to read.
+    Returns:
+        The updates in file order.
+    readArcUpdates complexity: O(k) for k updates.
+*/
+std::vector<ArcUpdate> readArcUpdates(const char* path) {
+    std::ifstream in(path);
+    if (!in) {
+        throw std::runtime_error(std::string("Cannot open update list: ") + path);
+    }
+    std::vector<ArcUpdate> updates;
+    ArcUpdate update;
+    while (in >> update.from >> update.to >> update.weight) {
+        if (update.weight < 0 || update.weight >= INF) {
+            throw std::runtime_error("Arc weight out of range in " + std::string(path) + ": " + std::to_string(update.weight));
+        }
+        updates.push_back(update);
+    }
+    return updates;
+}
+
+/*
+    Function: computeTree
+    Computes the shortest path tree of a source from scratch with the 4-ary heap used by the repairs.
+    Parameters:
+        g: The graph.
+        state: The search state receiving the tree.
+        source: The root of the tree.
+    computeTree complexity: O((n + m) log n).
+*/
+void computeTree(const Graph& g, SearchState& state, int source) {
+    DAryHeapQueue<4> queue(state);
+    dijkstraWithQueue(g, state, queue, source, -1);
+}
+
+/*
+    Function: initTreeRepair
+    Prepares the scratch space of tree repairs.
+    Parameters:
+        repair: The repair state.
+        g: The graph.
+        repairLimit: Fraction of the nodes a repair may settle before it falls back to a full search.
+    initTreeRepair complexity: O(n).
+*/
+void initTreeRepair(TreeRepair& repair, const Graph& g, double repairLimit) {
+    repair.affected.clear();
+    repair.isAffected.assign(g.nodeCount, 0);
+    repair.touchLimit = std::max(1, (int)(repairLimit * g.nodeCount));
+    repair.repairs = 0;
+    repair.recomputations = 0;
+    repair.settledNodes = 0;
+}
+
+/*
+    Function: repairTree
+    Brings the shortest path tree of a source up to date after the weight of arc (from, to) changed.
+    Parameters:
+        g: The graph, already holding the new weight.
+        rev: The reverse graph, also holding the new weight.
+        state: The search state holding the tree, computed with computeTree.
+        source: The root of the tree.
+        repair: Scratch space and statistics.
+        from: Tail of the changed arc.
+        to: Head of the changed arc.
+        oldWeight: Weight of the arc before the change.
+        newWeight: Weight of the arc after the change.
+    repairTree complexity: O(k log k + a) for k settled nodes and a arcs around them, at most that of computeTree.
+*/
+void repairTree(const Graph& g, const Graph& rev, SearchState& state, int source, TreeRepair& repair,
+                int from, int to, int oldWeight, int newWeight) {
+    int fromDist = searchDistance(state, from);
+    repair.repairs++;
+    if (fromDist >= INF || newWeight == oldWeight) {
+        return;  // The arc is not part of any shortest path
+    }
+
+    DAryHeapQueue<4> queue(state);
+    queue.clear();
+    int* dist = state.dist;
+    int* pred = state.pred;
+    int* heapPos = state.heapPos;
+    if (newWeight < oldWeight) {
+        touch(state, to);
+        if (fromDist + newWeight >= dist[to]) {
+            return;
+        }
+        dist[to] = fromDist + newWeight;
+        pred[to] = from;
+        heapPos[to] = -1;  // Extracted by the earlier search; inserted anew
+        queue.push(to, dist[to]);
+    } else {
+        if (pred[to] != from) {
+            return;  // Not a tree arc, so no distance depends on it
+        }
+        // Detach the subtree below the head of the arc
+        repair.affected.clear();
+        repair.affected.push_back(to);
+        repair.isAffected[to] = 1;
+        for (size_t k = 0; k < repair.affected.size() && (int)repair.affected.size() <= repair.touchLimit; k++) {
+            int x = repair.affected[k];
+            for (int i = g.offsets[x]; i < g.offsets[x + 1]; i++) {
+                int y = g.arcs[i].target;
+                if (!repair.isAffected[y] && state.stamp[y] == state.round && pred[y] == x) {
+                    repair.isAffected[y] = 1;
+                    repair.affected.push_back(y);
+                }
+            }
+        }
+        if ((int)repair.affected.size() <= repair.touchLimit) {
+            for (size_t k = 0; k < repair.affected.size(); k++) {
+                dist[repair.affected[k]] = INF;
+                pred[repair.affected[k]] = -1;
+            }
+            // Every detached node first takes its best arc from the rest of the tree
+            for (size_t k = 0; k < repair.affected.size(); k++) {
+                int y = repair.affected[k];
+                for (int i = rev.offsets[y]; i < rev.offsets[y + 1]; i++) {
+                    int x = rev.arcs[i].target;
+                    int d = searchDistance(state, x);
+                    if (!repair.isAffected[x] && d < INF && d + rev.arcs[i].weight < dist[y]) {
+                        dist[y] = d + rev.arcs[i].weight;
+                        pred[y] = x;
+                    }
+                }
+                heapPos[y] = -1;
+                if (dist[y] < INF) {
+                    queue.push(y, dist[y]);
+                }
+            }
+        }
+        for (size_t k = 0; k < repair.affected.size(); k++) {
+            repair.isAffected[repair.affected[k]] = 0;
+        }
+        if ((int)repair.affected.size() > repair.touchLimit) {
+            repair.repairs--;
+            repair.recomputations++;
+            computeTree(g, state, source);
+            return;
+        }
+    }
+
+    // Dijkstra over the region whose distances changed
+    int settled = 0;
+    while (!queue.empty()) {
+        int x = queue.pop();
+        if (++settled > repair.touchLimit) {
+            repair.repairs--;
+            repair.recomputations++;
+            computeTree(g, state, source);
+            return;
+        }
+        int arcEnd = g.offsets[x + 1];
+        for (int i = g.offsets[x]; i < arcEnd; i++) {
+            int y = g.arcs[i].target;
+            touch(state, y);
+            if (dist[x] + g.arcs[i].weight < dist[y]) {
+                dist[y] = dist[x] + g.arcs[i].weight;
+                pred[y] = x;
+                if (heapPos[y] == SETTLED) {
+                    heapPos[y] = -1;
+                }
+                queue.push(y, dist[y]);
+            }
+        }
+    }
+    repair.settledNodes += settled;
+}
+
+/*
+    Delta-stepping
+    Parallel single-source shortest paths. Tentative distances are grouped into buckets of width delta and
+    buckets are processed in increasing order. Within the current bucket all nodes are relaxed at once by
+    several threads: light arcs (weight <= delta) may put nodes back into the same bucket, so they are
+    relaxed repeatedly until the bucket stays empty, and heavy arcs are relaxed once per settled node
+    afterwards. Threads run the same loop and meet at a barrier after every phase.
+*/
+
+// Reusable barrier for a fixed number of threads
+struct PhaseBarrier {
+    std::mutex lock;
+    std::condition_variable released;
+    int threadCount;
+    int waiting;
+    long long generation;
+};
+
+// Shared state of a delta-stepping run
+struct DeltaSteppingState {
+    const Graph* g;
+    int delta;
+    int threadCount;
+    std::atomic<int>* dist;                              // Tentative distances
+    std::vector<std::vector<std::vector<int> > > buckets; // buckets[t][b]: nodes thread t put into bucket b
+    std::vector<int> frontier;       // Nodes relaxed in the current phase
+    std::vector<int> removed;        // Nodes taken from the current bucket, whose heavy arcs are pending
+    std::vector<int> frontierMark;   // Last phase in which a node joined the frontier
+    std::vector<int> removedMark;    // Last bucket from which a node was removed
+    int currentBucket;
+    int phase;                       // Number of the current phase
+    bool relaxHeavy;                 // True when the current phase relaxes heavy arcs
+    bool done;
+    PhaseBarrier barrier;
+};
+
+/*
+    Function: waitAtBarrier
+    Blocks until every thread of the barrier has arrived.
+    Parameters:
+        barrier: The barrier.
+    waitAtBarrier complexity: O(p) wake-ups for p threads.
+*/
+void waitAtBarrier(PhaseBarrier& barrier) {
+    std::unique_lock<std::mutex> guard(barrier.lock);
+    long long generation = barrier.generation;
+    barrier.waiting++;
+    if (barrier.waiting == barrier.threadCount) {
+        barrier.waiting = 0;
+        barrier.generation++;
+        barrier.released.notify_all();
+    } else {
+        barrier.released.wait(guard, [&]() { return barrier.generation != generation; });
+    }
+}
+
+/*
+    Function: deltaPlanPhase
+    Chooses the work of the next phase (run by a single thread between barriers). The current bucket is
+    gathered from all threads, dropping nodes whose distance has since moved to an earlier bucket and
+    duplicates; if it is empty the heavy arcs of the removed nodes are scheduled, and once those are done
+    the search moves to the next non-empty bucket.
+    Parameters:
+        state: The shared delta-stepping state.
+    deltaPlanPhase complexity: O(p * b + f), where b is the number of buckets skipped and f the frontier size.
+*/
+void deltaPlanPhase(DeltaSteppingState& state) {
+    state.phase++;
+    state.frontier.clear();
+    while (true) {
+        int b = state.currentBucket;
+        for (int t = 0; t < state.threadCount; t++) {
+            if (b < (int)state.buckets[t].size()) {
+                std::vector<int>& bucket = state.buckets[t][b];
+                for (size_t i = 0; i < bucket.size(); i++) {
+                    int v = bucket[i];
+                    int d = state.dist[v].load(std::memory_order_relaxed);
+                    if (d / state.delta == b && state.frontierMark[v] != state.phase) {
+                        state.frontierMark[v] = state.phase;
+                        state.frontier.push_back(v);
+                        if (state.removedMark[v] != b) {
+                            state.removedMark[v] = b;
+                            state.removed.push_back(v);
+                        }
+                    }
+                }
+                bucket.clear();
+            }
+        }
+        if (!state.frontier.empty()) {
+            state.relaxHeavy = false;
+            return;
+        }
+        if (!state.removed.empty()) {
+            state.frontier.swap(state.removed);
+            state.relaxHeavy = true;
+            return;
+        }
+
+        // Advance to the next bucket that still holds nodes
+        int next = -1;
+        for (int t = 0; t < state.threadCount; t++) {
+            for (int k = b + 1; k < (int)state.buckets[t].size() && (next == -1 || k < next); k++) {
+                if (!state.buckets[t][k].empty()) {
+                    next = k;
+                }
+            }
+        }
+        if (next == -1) {
+            state.done = true;
+            return;
+        }
+        state.currentBucket = next;
+    }
+}
+
+/*
+    Function: deltaRelax
+    Relaxes the light or heavy arcs of one slice of the frontier. Distances are lowered with an atomic
+    compare-and-swap, and each improved node is recorded in the calling thread's own bucket lists.
+    Parameters:
+        state: The shared delta-stepping state.
+        threadId: Index of the calling thread, which processes every threadCount-th frontier node.
+    deltaRelax complexity: O(sum of the degrees of the slice).
+*/
+void deltaRelax(DeltaSteppingState& state, int threadId) {
+    const Graph& g = *state.g;
+    std::vector<std::vector<int> >& myBuckets = state.buckets[threadId];
+    for (size_t i = threadId; i < state.frontier.size(); i += state.threadCount) {
+        int u = state.frontier[i];
+        int du = state.dist[u].load(std::memory_order_relaxed);
+        for (int a = g.offsets[u]; a < g.offsets[u + 1]; a++) {
+            int weight = g.arcs[a].weight;
+            if ((weight > state.delta) != state.relaxHeavy) {
+                continue;
+            }
+            int v = g.arcs[a].target;
+            int nd = du + weight;
+            int current = state.dist[v].load(std::memory_order_relaxed);
+            while (nd < current && !state.dist[v].compare_exchange_weak(current, nd, std::memory_order_relaxed)) {
+            }
+            if (nd < current) {
+                int b = nd / state.delta;
+                if (b >= (int)myBuckets.size()) {
+                    myBuckets.resize(b + 1);
+                }
+                myBuckets[b].push_back(v);
+            }
+        }
+    }
+}
+
+/*
+    Function: deltaStepping
+    Computes single-source shortest path distances with delta-stepping on several threads.
+    Parameters:
+        g: The graph.
+        source: The start node.
+        delta: Bucket width; arcs heavier than delta are relaxed once per node.
+        threadCount: Number of threads.
+    Returns:
+        The distance of every node slot (INF if unreachable); entries beyond the graph are INF except the source.
+    deltaStepping complexity: O(n + m + L / delta * phases) work, where L is the largest distance; the
+    relaxations of each phase are divided among the threads.
+*/
+std::vector<int> deltaStepping(const Graph& g, int source, int delta, int threadCount) {
+    int slots = std::max(g.nodeCount, source + 1);
+    DeltaSteppingState state;
+    state.g = &g;
+    state.delta = std::max(1, delta);
+    state.threadCount = threadCount;
+    state.dist = new std::atomic<int>[slots];
+    for (int i = 0; i < slots; i++) {
+        state.dist[i].store(INF, std::memory_order_relaxed);
+    }
+    state.buckets.resize(threadCount);
+    state.frontierMark.assign(slots, -1);
+    state.removedMark.assign(slots, -1);
+    state.currentBucket = 0;
+    state.phase = 0;
+    state.relaxHeavy = false;
+    state.done = false;
+    state.barrier.threadCount = threadCount;
+    state.barrier.waiting = 0;
+    state.barrier.generation = 0;
+
+    state.dist[source].store(0, std::memory_order_relaxed);
+    if (source < g.nodeCount) {
+        state.buckets[0].resize(1);
+        state.buckets[0][0].push_back(source);
+    }
+
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threadCount; t++) {
+        workers.push_back(std::thread([&state, t]() {
+            while (true) {
+                if (t == 0) {
+                    deltaPlanPhase(state);
+                }
+                waitAtBarrier(state.barrier);
+                if (state.done) {
+                    return;
+                }
+                deltaRelax(state, t);
+                waitAtBarrier(state.barrier);
+            }
+        }));
+    }
+    for (size_t t = 0; t < workers.size(); t++) {
+        workers[t].join();
+    }
+
+    std::vector<int> result(slots);
+    for (int i = 0; i < slots; i++) {
+        result[i] = state.dist[i].load(std::memory_order_relaxed);
+    }
+    delete[] state.dist;
+    return result;
+}
+
+/*
+    Function: defaultDelta
+    Picks a bucket width for delta-stepping: the average arc weight, which keeps roughly one light
+    relaxation wave per bucket on road graphs.
+    Parameters:
+        g: The graph.
+    Returns:
+        The bucket width.
+    defaultDelta complexity: O(m).
+*/
+int defaultDelta(const Graph& g) {
+    long long total = 0;
+    for (int i = 0; i < g.arcCount; i++) {
+        total += g.arcs[i].weight;
+    }
+    return g.arcCount > 0 ? std::max(1LL, total / g.arcCount) : 1;
+}
+
+/*
+    Contraction Hierarchies (CH)
+    The graph is preprocessed once by contracting nodes in order of importance. Contracting a node removes it
+    from the remaining graph and adds shortcut arcs between its neighbours whenever the path through the node
+    is the only shortest path (checked with a bounded local "witness" search). Every node receives a rank equal
+    to its contraction order, and the resulting hierarchy keeps, for every node, the arcs that lead to higher
+    ranked nodes. A shortest s-t distance is then found by a bidirectional search that only moves upward in
+    rank from both s and t, which settles a few hundred nodes instead of the whole graph.
+*/
+
+#define CH_SIMULATION_SETTLE_LIMIT 50   // Witness search budget while estimating a node's priority
+#define CH_CONTRACTION_SETTLE_LIMIT 500 // Witness search budget while actually contracting a node
+#define CH_FILE_MAGIC 0x31484348        // "HCH1" written at the start of a saved hierarchy
+
+// Structure representing an arc of the hierarchy (original arc or shortcut)
+struct ChArc {
+    int node;      // Neighbouring node (head for outgoing arcs, tail for incoming arcs)
+    int weight;    // Weight of the arc
+};
+
+// Upward graphs produced by the preprocessing, stored in compressed (offset + arc array) form
+struct ChIndex {
+    int nodeCount;                  // Number of node slots (ids 0 .. nodeCount - 1)
+    std::vector<int> fwdOffsets;    // fwdArcs[fwdOffsets[u] .. fwdOffsets[u + 1]) are upward arcs u -> x
+    std::vector<ChArc> fwdArcs;
+    std::vector<int> bwdOffsets;    // bwdArcs[bwdOffsets[u] .. bwdOffsets[u + 1]) are upward arcs x -> u
+    std::vector<ChArc> bwdArcs;
+};
+
+// Working state of the preprocessing: the remaining (not yet contracted) graph plus witness search buffers
+struct ChBuilder {
+    int nodeCount;
+    std::vector<std::vector<ChArc> > outArcs;   // Outgoing arcs between remaining nodes
+    std::vector<std::vector<ChArc> > inArcs;    // Incoming arcs between remaining nodes
+    std::vector<int> deletedNeighbours;         // Number of already contracted neighbours of each node
+    std::vector<bool> contracted;               // Marks nodes that have been removed from the remaining graph
+    std::vector<int> witnessDist;               // Tentative distances of the current witness search
+    std::vector<int> witnessStamp;              // Round in which witnessDist[i] was last written
+    std::vector<std::pair<int, int> > witnessHeap;
+    int witnessRound;
+};
+
+// Scratch space of the bidirectional upward query, reused between queries
+struct ChQueryState {
+    std::vector<int> distF, distB;      // Forward and backward tentative distances
+    std::vector<int> stampF, stampB;    // Query round in which the distances were last written
+    std::vector<std::pair<int, int> > heapF, heapB;
+    int round;
+    long long settled;                  // Nodes settled by the last query (both directions)
+};
+
+/*
+    Function: chAddArc
+    Inserts the arc from -> to into the remaining graph or lowers its weight if it already exists.
+    Parameters:
+        builder: The preprocessing state.
+        from: Tail of the arc.
+        to: Head of the arc.
+        weight: Weight of the arc.
+    chAddArc complexity: O(d), where d is the degree of the two endpoints (parallel arcs are merged).
+*/
+void chAddArc(ChBuilder& builder, int from, int to, int weight) {
+    std::vector<ChArc>& out = builder.outArcs[from];
+    for (size_t i = 0; i < out.size(); i++) {
+        if (out[i].node == to) {
+            if (weight < out[i].weight) {
+                out[i].weight = weight;
+                std::vector<ChArc>& in = builder.inArcs[to];
+                for (size_t j = 0; j < in.size(); j++) {
+                    if (in[j].node == from) {
+                        in[j].weight = weight;
+                    }
+                }
+            }
+            return;
+        }
+    }
+    ChArc outArc = {to, weight};
+    ChArc inArc = {from, weight};
+    out.push_back(outArc);
+    builder.inArcs[to].push_back(inArc);
+}
+
+/*
+    Function: chWitnessSearch
+    Runs a bounded Dijkstra from source over the remaining graph, ignoring the node being contracted.
+    The search stops once the next distance exceeds maxDist or settleLimit nodes have been settled.
+    Parameters:
+        builder: The preprocessing state; distances are left in witnessDist for the current round.
+        source: Start node of the search.
+        skip: Node currently considered for contraction.
+        maxDist: Largest distance that can still replace a shortcut.
+        settleLimit: Maximum number of nodes to settle.
+    chWitnessSearch complexity: O(k log k), where k is bounded by settleLimit times the local degree.
+*/
+void chWitnessSearch(ChBuilder& builder, int source, int skip, int maxDist, int settleLimit) {
+    builder.witnessRound++;
+    std::vector<std::pair<int, int> >& heap = builder.witnessHeap;
+    heap.clear();
+    builder.witnessDist[source] = 0;
+    builder.witnessStamp[source] = builder.witnessRound;
+    heap.push_back(std::make_pair(0, source));
+
+    int settled = 0;
+    while (!heap.empty() && settled < settleLimit) {
+        std::pop_heap(heap.begin(), heap.end(), std::greater<std::pair<int, int> >());
+        int d = heap.back().first;
+        int u = heap.back().second;
+        heap.pop_back();
+        if (d > builder.witnessDist[u]) {
+            continue;  // Stale heap entry
+        }
+        if (d > maxDist) {
+            break;
+        }
+        settled++;
+
+        const std::vector<ChArc>& out = builder.outArcs[u];
+        for (size_t i = 0; i < out.size(); i++) {
+            int v = out[i].node;
+            if (v == skip) {
+                continue;
+            }
+            int nd = d + out[i].weight;
+            if (builder.witnessStamp[v] != builder.witnessRound || nd < builder.witnessDist[v]) {
+                builder.witnessStamp[v] = builder.witnessRound;
+                builder.witnessDist[v] = nd;
+                heap.push_back(std::make_pair(nd, v));
+                std::push_heap(heap.begin(), heap.end(), std::greater<std::pair<int, int> >());
+            }
+        }
+    }
+}
+
+/*
+    Function: chProcessNode
+    Determines the shortcuts needed to contract node v and optionally inserts them.
+    Parameters:
+        builder: The preprocessing state.
+        v: The node to examine.
+        simulate: When true no shortcut is added, only counted.
+    Returns:
+        The number of shortcuts required to contract v.
+    chProcessNode complexity: O(in(v) * (witness search + out(v))).
+*/
+int chProcessNode(ChBuilder& builder, int v, bool simulate) {
+    const std::vector<ChArc>& in = builder.inArcs[v];
+    const std::vector<ChArc>& out = builder.outArcs[v];
+    int settleLimit = simulate ? CH_SIMULATION_SETTLE_LIMIT : CH_CONTRACTION_SETTLE_LIMIT;
+
+    int maxOut = 0;
+    for (size_t j = 0; j < out.size(); j++) {
+        maxOut = std::max(maxOut, out[j].weight);
+    }
+
+    int shortcuts = 0;
+    for (size_t i = 0; i < in.size(); i++) {
+        int u = in[i].node;
+        chWitnessSearch(builder, u, v, in[i].weight + maxOut, settleLimit);
+        for (size_t j = 0; j < out.size(); j++) {
+            int x = out[j].node;
+            if (x == u) {
+                continue;
+            }
+            int viaV = in[i].weight + out[j].weight;
+            bool hasWitness = builder.witnessStamp[x] == builder.witnessRound && builder.witnessDist[x] <= viaV;
+            if (!hasWitness) {
+                shortcuts++;
+                if (!simulate) {
+                    chAddArc(builder, u, x, viaV);
+                }
+            }
+        }
+    }
+    return shortcuts;
+}
+
+/*
+    Function: chPriority
+    Computes the contraction priority of a node: the edge difference (shortcuts added minus arcs removed)
+    plus the number of already contracted neighbours, which spreads contraction uniformly over the graph.
+    Parameters:
+        builder: The preprocessing state.
+        v: The node to evaluate.
+    Returns:
+        The priority of v (lower values are contracted first).
+    chPriority complexity: Same as chProcessNode in simulation mode.
+*/
+int chPriority(ChBuilder& builder, int v) {
+    int shortcuts = chProcessNode(builder, v, true);
+    int removed = builder.inArcs[v].size() + builder.outArcs[v].size();
+    return shortcuts - removed + builder.deletedNeighbours[v];
+}
+
+/*
+    Function: chRemoveArcTo
+    Removes every arc pointing to node v from an arc list.
+    Parameters:
+        arcs: The arc list to filter.
+        v: The node to remove.
+    chRemoveArcTo complexity: O(d), where d is the length of the list.
+*/
+void chRemoveArcTo(std::vector<ChArc>& arcs, int v) {
+    size_t kept = 0;
+    for (size_t i = 0; i < arcs.size(); i++) {
+        if (arcs[i].node != v) {
+            arcs[kept++] = arcs[i];
+        }
+    }
+    arcs.resize(kept);
+}
+
+/*
+    Function: buildContractionHierarchy
+    Contracts every node of the CSR graph and returns the upward search graphs.
+    Nodes are taken from a lazily updated priority queue: a popped node is re-evaluated and pushed back
+    if its priority got worse than the next candidate, otherwise it is contracted.
+    Parameters:
+        graph: The graph to preprocess.
+        contractionOrder: If not NULL, receives the nodes in the order they were contracted (least important first).
+    Returns:
+        The contraction hierarchy index.
+    buildContractionHierarchy complexity: Roughly O(n * d * w), where d is the average degree during
+    contraction and w the bounded witness search cost; in practice seconds to minutes on road graphs.
+*/
+ChIndex buildContractionHierarchy(const Graph& graph, std::vector<int>* contractionOrder = NULL) {
+    int nodeCount = graph.nodeCount;
+    ChBuilder builder;
+    builder.nodeCount = nodeCount;
+    builder.outArcs.resize(nodeCount);
+    builder.inArcs.resize(nodeCount);
+    builder.deletedNeighbours.assign(nodeCount, 0);
+    builder.contracted.assign(nodeCount, false);
+    builder.witnessDist.assign(nodeCount, INF);
+    builder.witnessStamp.assign(nodeCount, 0);
+    builder.witnessRound = 0;
+
+    for (int u = 0; u < nodeCount; u++) {
+        for (int i = graph.offsets[u]; i < graph.offsets[u + 1]; i++) {
+            if (graph.arcs[i].target != u) {
+                chAddArc(builder, u, graph.arcs[i].target, graph.arcs[i].weight);
+            }
+        }
+    }
+
+    std::vector<std::pair<int, int> > queue;
+    for (int v = 0; v < nodeCount; v++) {
+        queue.push_back(std::make_pair(chPriority(builder, v), v));
+    }
+    std::make_heap(queue.begin(), queue.end(), std::greater<std::pair<int, int> >());
+
+    // Upward arcs of each node, captured at the moment it is contracted
+    std::vector<std::vector<ChArc> > upOut(nodeCount);
+    std::vector<std::vector<ChArc> > upIn(nodeCount);
+
+    int contractedCount = 0;
+    while (!queue.empty()) {
+        std::pop_heap(queue.begin(), queue.end(), std::greater<std::pair<int, int> >());
+        int v = queue.back().second;
+        queue.pop_back();
+        if (builder.contracted[v]) {
+            continue;
+        }
+
+        int priority = chPriority(builder, v);
+        if (!queue.empty() && priority > queue.front().first) {
+            queue.push_back(std::make_pair(priority, v));
+            std::push_heap(queue.begin(), queue.end(), std::greater<std::pair<int, int> >());
+            continue;
+        }
+
+        chProcessNode(builder, v, false);
+        upOut[v] = builder.outArcs[v];
+        upIn[v] = builder.inArcs[v];
+        builder.contracted[v] = true;
+        contractedCount++;
+        if (contractionOrder != NULL) {
+            contractionOrder->push_back(v);
+        }
+
+        // Detach v from the remaining graph and refresh the priority of its neighbours
+        for (size_t i = 0; i < upOut[v].size(); i++) {
+            int x = upOut[v][i].node;
+            chRemoveArcTo(builder.inArcs[x], v);
+            builder.deletedNeighbours[x]++;
+        }
+        for (size_t i = 0; i < upIn[v].size(); i++) {
+            int u = upIn[v][i].node;
+            chRemoveArcTo(builder.outArcs[u], v);
+            builder.deletedNeighbours[u]++;
+        }
+        std::vector<ChArc>().swap(builder.outArcs[v]);
+        std::vector<ChArc>().swap(builder.inArcs[v]);
+
+        for (size_t i = 0; i < upOut[v].size(); i++) {
+            int x = upOut[v][i].node;
+            queue.push_back(std::make_pair(chPriority(builder, x), x));
+            std::push_heap(queue.begin(), queue.end(), std::greater<std::pair<int, int> >());
+        }
+        for (size_t i = 0; i < upIn[v].size(); i++) {
+            int u = upIn[v][i].node;
+            queue.push_back(std::make_pair(chPriority(builder, u), u));
+            std::push_heap(queue.begin(), queue.end(), std::greater<std::pair<int, int> >());
+        }
+
+        if (contractedCount % 50000 == 0) {
+            std::cerr << "Contracted " << contractedCount << " / " << nodeCount << " nodes" << std::endl;
+        }
+    }
+
+    ChIndex index;
+    index.nodeCount = nodeCount;
+    index.fwdOffsets.assign(nodeCount + 1, 0);
+    index.bwdOffsets.assign(nodeCount + 1, 0);
+    for (int v = 0; v < nodeCount; v++) {
+        index.fwdOffsets[v + 1] = index.fwdOffsets[v] + upOut[v].size();
+        index.bwdOffsets[v + 1] = index.bwdOffsets[v] + upIn[v].size();
+        index.fwdArcs.insert(index.fwdArcs.end(), upOut[v].begin(), upOut[v].end());
+        index.bwdArcs.insert(index.bwdArcs.end(), upIn[v].begin(), upIn[v].end());
+    }
+    return index;
+}
+
+/*
+    Function: saveContractionHierarchy
+    Writes the hierarchy to a binary file so that it can be queried later without preprocessing.
+    Parameters:
+        index: The hierarchy to save.
+        path: Destination file.
+    saveContractionHierarchy complexity: O(n + m'), where m' is the number of upward arcs.
+*/
+void saveContractionHierarchy(const ChIndex& index, const char* path) {
+    std::ofstream out(path, std::ios::binary);
+    if (!out) {
+        throw std::runtime_error(std::string("Cannot open hierarchy file for writing: ") + path);
+    }
+    int header[4] = {CH_FILE_MAGIC, index.nodeCount, (int)index.fwdArcs.size(), (int)index.bwdArcs.size()};
+    out.write((const char*)header, sizeof(header));
+    out.write((const char*)index.fwdOffsets.data(), index.fwdOffsets.size() * sizeof(int));
+    out.write((const char*)index.fwdArcs.data(), index.fwdArcs.size() * sizeof(ChArc));
+    out.write((const char*)index.bwdOffsets.data(), index.bwdOffsets.size() * sizeof(int));
+    out.write((const char*)index.bwdArcs.data(), index.bwdArcs.size() * sizeof(ChArc));
+    if (!out) {
+        throw std::runtime_error(std::string("Failed to write hierarchy file: ") + path);
+    }
+}
+
+/*
+    Function: loadContractionHierarchy
+    Reads a hierarchy previously written by saveContractionHierarchy.
+    Parameters:
+        path: Source file.
+    Returns:
+        The loaded hierarchy.
+    loadContractionHierarchy complexity: O(n + m').
+*/
+ChIndex loadContractionHierarchy(const char* path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        throw std::runtime_error(std::string("Cannot open hierarchy file: ") + path);
+    }
+    int header[4];
+    in.read((char*)header, sizeof(header));
+    if (!in || header[0] != CH_FILE_MAGIC) {
+        throw std::runtime_error(std::string("Not a contraction hierarchy file: ") + path);
+    }
+
+    ChIndex index;
+    index.nodeCount = header[1];
+    index.fwdOffsets.resize(index.nodeCount + 1);
+    index.fwdArcs.resize(header[2]);
+    index.bwdOffsets.resize(index.nodeCount + 1);
+    index.bwdArcs.resize(header[3]);
+    in.read((char*)index.fwdOffsets.data(), index.fwdOffsets.size() * sizeof(int));
+    in.read((char*)index.fwdArcs.data(), index.fwdArcs.size() * sizeof(ChArc));
+    in.read((char*)index.bwdOffsets.data(), index.bwdOffsets.size() * sizeof(int));
+    in.read((char*)index.bwdArcs.data(), index.bwdArcs.size() * sizeof(ChArc));
+    if (!in) {
+        throw std::runtime_error(std::string("Truncated hierarchy file: ") + path);
+    }
+    return index;
+}
+
+/*
+    Function: initChQueryState
+    Allocates the scratch arrays of the upward query for a given hierarchy.
+    Parameters:
+        state: The state to initialise.
+        nodeCount: Number of node slots of the hierarchy.
+    initChQueryState complexity: O(n), performed once before answering queries.
+*/
+void initChQueryState(ChQueryState& state, int nodeCount) {
+    state.distF.assign(nodeCount, INF);
+    state.distB.assign(nodeCount, INF);
+    state.stampF.assign(nodeCount, 0);
+    state.stampB.assign(nodeCount, 0);
+    state.round = 0;
+    state.settled = 0;
+}
+
+/*
+    Function: chSearchStep
+    Settles the next node of one direction of the upward query and relaxes its upward arcs.
+    Nodes that can be reached on a shorter path through a higher ranked node are "stalled" and
+    not expanded, since they cannot lie on a shortest up-down path.
+    Parameters:
+        heap, dist, stamp: The state of the searching direction.
+        otherDist, otherStamp: The state of the opposite direction, used to detect meeting nodes.
+        offsets, arcs: Upward arcs followed by this direction.
+        stallOffsets, stallArcs: Upward arcs of the opposite direction, used for stalling.
+        round: The current query round.
+        best: Shortest up-down distance found so far, updated in place.
+    Returns:
+        True if a node was settled.
+    chSearchStep complexity: O(d log k) for a node of upward degree d and heap size k.
+*/
+bool chSearchStep(std::vector<std::pair<int, int> >& heap, std::vector<int>& dist, std::vector<int>& stamp,
+                  const std::vector<int>& otherDist, const std::vector<int>& otherStamp,
+                  const std::vector<int>& offsets, const std::vector<ChArc>& arcs,
+                  const std::vector<int>& stallOffsets, const std::vector<ChArc>& stallArcs,
+                  int round, int& best) {
+    std::pop_heap(heap.begin(), heap.end(), std::greater<std::pair<int, int> >());
+    int d = heap.back().first;
+    int u = heap.back().second;
+    heap.pop_back();
+    if (d > dist[u]) {
+        return false;  // Stale heap entry
+    }
+
+    if (otherStamp[u] == round && d + otherDist[u] < best) {
+        best = d + otherDist[u];
+    }
+
+    for (int i = stallOffsets[u]; i < stallOffsets[u + 1]; i++) {
+        int x = stallArcs[i].node;
+        if (stamp[x] == round && dist[x] + stallArcs[i].weight < d) {
+            return true;  // Stalled: u is not on a shortest upward path
+        }
+    }
+
+    for (int i = offsets[u]; i < offsets[u + 1]; i++) {
+        int v = arcs[i].node;
+        int nd = d + arcs[i].weight;
+        if (stamp[v] != round || nd < dist[v]) {
+            stamp[v] = round;
+            dist[v] = nd;
+            heap.push_back(std::make_pair(nd, v));
+            std::push_heap(heap.begin(), heap.end(), std::greater<std::pair<int, int> >());
+        }
+    }
+    return true;
+}
+
+/*
+    Function: chQuery
+    Answers a point-to-point distance query with a bidirectional upward search on the hierarchy.
+    Both directions are advanced alternately and each one stops as soon as its smallest key is
+    not below the best meeting distance found so far.
+    Parameters:
+        index: The contraction hierarchy.
+        state: Reusable query scratch space.
+        source: Start node.
+        target: Destination node.
+    Returns:
+        The shortest distance from source to target, or INF if unreachable.
+    chQuery complexity: O(k log k), where k is the size of the upward search spaces (typically a few hundred nodes).
+*/
+int chQuery(const ChIndex& index, ChQueryState& state, int source, int target) {
+    state.round++;
+    state.heapF.clear();
+    state.heapB.clear();
+    state.settled = 0;
+
+    state.distF[source] = 0;
+    state.stampF[source] = state.round;
+    state.heapF.push_back(std::make_pair(0, source));
+    state.distB[target] = 0;
+    state.stampB[target] = state.round;
+    state.heapB.push_back(std::make_pair(0, target));
+
+    int best = INF;
+    bool forwardTurn = true;
+    while (true) {
+        bool forwardOpen = !state.heapF.empty() && state.heapF.front().first < best;
+        bool backwardOpen = !state.heapB.empty() && state.heapB.front().first < best;
+        if (!forwardOpen && !backwardOpen) {
+            break;
+        }
+        if ((forwardTurn && forwardOpen) || !backwardOpen) {
+            state.settled += chSearchStep(state.heapF, state.distF, state.stampF, state.distB, state.stampB,
+                                          index.fwdOffsets, index.fwdArcs, index.bwdOffsets, index.bwdArcs,
+                                          state.round, best);
+        } else {
+            state.settled += chSearchStep(state.heapB, state.distB, state.stampB, state.distF, state.stampF,
+                                          index.bwdOffsets, index.bwdArcs, index.fwdOffsets, index.fwdArcs,
+                                          state.round, best);
+        }
+        forwardTurn = !forwardTurn;
+    }
+    return best;
+}
+
+/*
+    Hub labeling (HL)
+    Every node receives a forward label, the hubs it reaches with their distances, and a backward label, the
+    hubs that reach it. The labels are built by pruned landmark labeling: nodes become hubs from the most to
+    the least important one, and the Dijkstra search of each hub only keeps (and expands) the nodes whose
+    distance is not already covered by the labels built before. Hubs are stored by their position in that
+    order, so every label is sorted and d(s, t) is the smallest d(s, h) + d(h, t) over the hubs shared by the
+    forward label of s and the backward label of t, found by merging two short arrays without any search.
+*/
+
+#define HL_FILE_MAGIC 0x31424c48    // "HLB1" written at the start of saved hub labels
+
+// Order in which the nodes become hubs
+enum HubOrder {
+    HUB_ORDER_CH,       // Reverse contraction order of a contraction hierarchy built for the purpose
+    HUB_ORDER_DEGREE    // Decreasing total degree
+};
+
+// Labels of every node in compressed (offset + array) form, with hub ranks and distances in separate arrays
+struct HubLabels {
+    int nodeCount;
+    std::vector<int> fwdOffsets;    // fwdHubs[fwdOffsets[v] .. fwdOffsets[v + 1]) are the hubs reachable from v
+    std::vector<int> fwdHubs;
+    std::vector<int> fwdDists;
+    std::vector<int> bwdOffsets;    // bwdHubs[bwdOffsets[v] .. bwdOffsets[v + 1]) are the hubs that reach v
+    std::vector<int> bwdHubs;
+    std::vector<int> bwdDists;
+};
+
+// Scratch space of the pruned searches, reused for every hub
+struct HlBuildState {
+    std::vector<int> dist;          // Tentative distances of the current search, INF when untouched
+    std::vector<int> touched;       // Nodes whose dist entry must be reset after the search
+    std::vector<int> hubDist;       // Label of the current hub, indexed by hub rank (INF for other hubs)
+    std::vector<std::pair<int, int> > heap;
+};
+
+/*
+    Function: computeHubOrder
+    Ranks the nodes by importance for pruned landmark labeling. Hubs that cover many shortest paths early
+    keep the later labels small, which the contraction order of a hierarchy captures far better than degree.
+    Parameters:
+        g: The graph.
+        kind: The ordering to compute.
+    Returns:
+        The nodes from the most to the least important one.
+    computeHubOrder complexity: That of buildContractionHierarchy for HUB_ORDER_CH, O(n log n + m) otherwise.
+*/
+std::vector<int> computeHubOrder(const Graph& g, HubOrder kind) {
+    std::vector<int> order;
+    if (kind == HUB_ORDER_CH) {
+        buildContractionHierarchy(g, &order);
+        std::reverse(order.begin(), order.end());
+        return order;
+    }
+
+    std::vector<int> degree(g.nodeCount, 0);
+    for (int u = 0; u < g.nodeCount; u++) {
+        degree[u] += g.offsets[u + 1] - g.offsets[u];
+        for (int i = g.offsets[u]; i < g.offsets[u + 1]; i++) {
+            degree[g.arcs[i].target]++;
+        }
+    }
+    order.resize(g.nodeCount);
+    for (int v = 0; v < g.nodeCount; v++) {
+        order[v] = v;
+    }
+    std::stable_sort(order.begin(), order.end(), [&degree](int a, int b) { return degree[a] > degree[b]; });
+    return order;
+}
+
+/*
+    Function: hlPrunedSearch
+    Runs the Dijkstra search of one hub and adds the hub to the label of every node it settles, except for
+    nodes whose distance is already given by the earlier hubs; those are neither labelled nor expanded.
+    Run on the graph it fills backward labels (hub -> v), run on the reverse graph forward labels (v -> hub).
+    Parameters:
+        g: The graph to search (the reverse graph for forward labels).
+        hub: The node that becomes a hub.
+        rank: Position of the hub in the hub order.
+        hubLabel: Opposite-direction label of the hub, used to test whether a distance is covered.
+        labels: Labels being built, extended in place.
+        state: Reusable scratch space.
+    Returns:
+        The number of labels the hub was added to.
+    hlPrunedSearch complexity: O(k (log k + L)) for k settled nodes with labels of size L.
+*/
+int hlPrunedSearch(const Graph& g, int hub, int rank, const std::vector<std::pair<int, int> >& hubLabel,
+                    std::vector<std::vector<std::pair<int, int> > >& labels, HlBuildState& state) {
+    for (size_t i = 0; i < hubLabel.size(); i++) {
+        state.hubDist[hubLabel[i].first] = hubLabel[i].second;
+    }
+    state.heap.clear();
+    state.dist[hub] = 0;
+    state.touched.push_back(hub);
+    state.heap.push_back(std::make_pair(0, hub));
+
+    int labelled = 0;
+    while (!state.heap.empty()) {
+        std::pop_heap(state.heap.begin(), state.heap.end(), std::greater<std::pair<int, int> >());
+        int d = state.heap.back().first;
+        int u = state.heap.back().second;
+        state.heap.pop_back();
+        if (d > state.dist[u]) {
+            continue;  // Stale heap entry
+        }
+
+        const std::vector<std::pair<int, int> >& label = labels[u];
+        bool covered = false;
+        for (size_t i = 0; i < label.size() && !covered; i++) {
+            int viaHub = state.hubDist[label[i].first];
+            covered = viaHub < INF && viaHub + label[i].second <= d;
+        }
+        if (covered) {
+            continue;
+        }
+        labels[u].push_back(std::make_pair(rank, d));
+        labelled++;
+
+        for (int i = g.offsets[u]; i < g.offsets[u + 1]; i++) {
+            int v = g.arcs[i].target;
+            int nd = d + g.arcs[i].weight;
+            if (nd < state.dist[v]) {
+                if (state.dist[v] == INF) {
+                    state.touched.push_back(v);
+                }
+                state.dist[v] = nd;
+                state.heap.push_back(std::make_pair(nd, v));
+                std::push_heap(state.heap.begin(), state.heap.end(), std::greater<std::pair<int, int> >());
+            }
+        }
+    }
+
+    for (size_t i = 0; i < state.touched.size(); i++) {
+        state.dist[state.touched[i]] = INF;
+    }
+    state.touched.clear();
+    for (size_t i = 0; i < hubLabel.size(); i++) {
+        state.hubDist[hubLabel[i].first] = INF;
+    }
+    return labelled;
+}
+
+/*
+    Function: buildHubLabels
+    Computes forward and backward hub labels of every node with pruned landmark labeling.
+    Parameters:
+        g: The graph.
+        kind: The hub order to use.
+    Returns:
+        The labels in compressed form.
+    buildHubLabels complexity: O(n * k (log k + L)) for pruned searches settling k nodes and labels of size L;
+    minutes on road graphs with the contraction order.
+*/
+HubLabels buildHubLabels(const Graph& g, HubOrder kind) {
+    int nodeCount = g.nodeCount;
+    std::vector<int> order = computeHubOrder(g, kind);
+    Graph reverse = buildReverseGraph(g);
+
+    HlBuildState state;
+    state.dist.assign(nodeCount, INF);
+    state.hubDist.assign(nodeCount, INF);
+    std::vector<std::vector<std::pair<int, int> > > fwd(nodeCount);
+    std::vector<std::vector<std::pair<int, int> > > bwd(nodeCount);
+    long long entryCount = 0;
+    for (int rank = 0; rank < nodeCount; rank++) {
+        int hub = order[rank];
+        entryCount += hlPrunedSearch(g, hub, rank, fwd[hub], bwd, state);
+        entryCount += hlPrunedSearch(reverse, hub, rank, bwd[hub], fwd, state);
+        if ((rank + 1) % 50000 == 0) {
+            std::cerr << "Labelled from " << rank + 1 << " / " << nodeCount << " hubs, "
+                      << (double)entryCount / nodeCount << " entries per node" << std::endl;
+        }
+    }
+    freeGraph(reverse);
+
+    HubLabels labels;
+    labels.nodeCount = nodeCount;
+    labels.fwdOffsets.assign(nodeCount + 1, 0);
+    labels.bwdOffsets.assign(nodeCount + 1, 0);
+    for (int v = 0; v < nodeCount; v++) {
+        labels.fwdOffsets[v + 1] = labels.fwdOffsets[v] + fwd[v].size();
+        labels.bwdOffsets[v + 1] = labels.bwdOffsets[v] + bwd[v].size();
+        for (size_t i = 0; i < fwd[v].size(); i++) {
+            labels.fwdHubs.push_back(fwd[v][i].first);
+            labels.fwdDists.push_back(fwd[v][i].second);
+        }
+        for (size_t i = 0; i < bwd[v].size(); i++) {
+            labels.bwdHubs.push_back(bwd[v][i].first);
+            labels.bwdDists.push_back(bwd[v][i].second);
+        }
+        std::vector<std::pair<int, int> >().swap(fwd[v]);
+        std::vector<std::pair<int, int> >().swap(bwd[v]);
+    }
+    return labels;
+}
+
+/*
+    Function: saveHubLabels
+    Writes hub labels to a binary file.
+    Parameters:
+        labels: The labels to save.
+        path: Destination file.
+    saveHubLabels complexity: O(n L) for labels of average size L.
+*/
+void saveHubLabels(const HubLabels& labels, const char* path) {
+    std::ofstream out(path, std::ios::binary);
+    if (!out) {
+        throw std::runtime_error(std::string("Cannot open label file for writing: ") + path);
+    }
+    int header[4] = {HL_FILE_MAGIC, labels.nodeCount, (int)labels.fwdHubs.size(), (int)labels.bwdHubs.size()};
+    out.write((const char*)header, sizeof(header));
+    out.write((const char*)labels.fwdOffsets.data(), labels.fwdOffsets.size() * sizeof(int));
+    out.write((const char*)labels.fwdHubs.data(), labels.fwdHubs.size() * sizeof(int));
+    out.write((const char*)labels.fwdDists.data(), labels.fwdDists.size() * sizeof(int));
+    out.write((const char*)labels.bwdOffsets.data(), labels.bwdOffsets.size() * sizeof(int));
+    out.write((const char*)labels.bwdHubs.data(), labels.bwdHubs.size() * sizeof(int));
+    out.write((const char*)labels.bwdDists.data(), labels.bwdDists.size() * sizeof(int));
+    if (!out) {
+        throw std::runtime_error(std::string("Failed to write label file: ") + path);
+    }
+}
+
+/*
+    Function: loadHubLabels
+    Reads hub labels written by saveHubLabels.
+    Parameters:
+        path: Source file.
+    Returns:
+        The loaded labels.
+    loadHubLabels complexity: O(n L).
+*/
+HubLabels loadHubLabels(const char* path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        throw std::runtime_error(std::string("Cannot open label file: ") + path);
+    }
+    int header[4];
+    in.read((char*)header, sizeof(header));
+    if (!in || header[0] != HL_FILE_MAGIC) {
+        throw std::runtime_error(std::string("Not a hub label file: ") + path);
+    }
+
+    HubLabels labels;
+    labels.nodeCount = header[1];
+    labels.fwdOffsets.resize(labels.nodeCount + 1);
+    labels.fwdHubs.resize(header[2]);
+    labels.fwdDists.resize(header[2]);
+    labels.bwdOffsets.resize(labels.nodeCount + 1);
+    labels.bwdHubs.resize(header[3]);
+    labels.bwdDists.resize(header[3]);
+    in.read((char*)labels.fwdOffsets.data(), labels.fwdOffsets.size() * sizeof(int));
+    in.read((char*)labels.fwdHubs.data(), labels.fwdHubs.size() * sizeof(int));
+    in.read((char*)labels.fwdDists.data(), labels.fwdDists.size() * sizeof(int));
+    in.read((char*)labels.bwdOffsets.data(), labels.bwdOffsets.size() * sizeof(int));
+    in.read((char*)labels.bwdHubs.data(), labels.bwdHubs.size() * sizeof(int));
+    in.read((char*)labels.bwdDists.data(), labels.bwdDists.size() * sizeof(int));
+    if (!in) {
+        throw std::runtime_error(std::string("Truncated label file: ") + path);
+    }
+    return labels;
+}
+
+/*
+    Function: hlQuery
+    Answers a distance query by intersecting the forward label of the source with the backward label of
+    the target. With SSE2 the sorted hub arrays are compared four against four (the second block rotated
+    three times), and only blocks containing a common hub are resolved with scalar code; the block whose
+    last hub is smaller is then skipped. A scalar merge finishes the remaining entries.
+    Parameters:
+        labels: The hub labels.
+        source: Start node.
+        target: Destination node.
+    Returns:
+        The shortest distance from source to target, or INF if unreachable.
+    hlQuery complexity: O(L) for labels of size L.
+*/
+int hlQuery(const HubLabels& labels, int source, int target) {
+    const int* fwdHubs = labels.fwdHubs.data();
+    const int* fwdDists = labels.fwdDists.data();
+    const int* bwdHubs = labels.bwdHubs.data();
+    const int* bwdDists = labels.bwdDists.data();
+    int i = labels.fwdOffsets[source];
+    int iEnd = labels.fwdOffsets[source + 1];
+    int j = labels.bwdOffsets[target];
+    int jEnd = labels.bwdOffsets[target + 1];
+    int best = INF;
+
+#if defined(__SSE2__)
+    while (i + 4 <= iEnd && j + 4 <= jEnd) {
+        __m128i a = _mm_loadu_si128((const __m128i*)(fwdHubs + i));
+        __m128i b = _mm_loadu_si128((const __m128i*)(bwdHubs + j));
+        __m128i equal = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi32(a, b), _mm_cmpeq_epi32(a, _mm_shuffle_epi32(b, _MM_SHUFFLE(0, 3, 2, 1)))),
+            _mm_or_si128(_mm_cmpeq_epi32(a, _mm_shuffle_epi32(b, _MM_SHUFFLE(1, 0, 3, 2))),
+                         _mm_cmpeq_epi32(a, _mm_shuffle_epi32(b, _MM_SHUFFLE(2, 1, 0, 3)))));
+        if (_mm_movemask_epi8(equal) != 0) {
+            for (int x = i; x < i + 4; x++) {
+                for (int y = j; y < j + 4; y++) {
+                    if (fwdHubs[x] == bwdHubs[y]) {
+                        best = std::min(best, fwdDists[x] + bwdDists[y]);
+                    }
+                }
+            }
+        }
+        int lastA = fwdHubs[i + 3];
+        int lastB = bwdHubs[j + 3];
+        if (lastA <= lastB) {
+            i += 4;
+        }
+        if (lastB <= lastA) {
+            j += 4;
+        }
+    }
+#endif
+
+    while (i < iEnd && j < jEnd) {
+        if (fwdHubs[i] < bwdHubs[j]) {
+            i++;
+        } else if (fwdHubs[i] > bwdHubs[j]) {
+            j++;
+        } else {
+            best = std::min(best, fwdDists[i] + bwdDists[j]);
+            i++;
+            j++;
+        }
+    }
+    return best;
+}
+
+/*
+    Customizable route planning (CRP)
+    The nodes are split once into nested cells on a few levels by recursive minimum cut bisection:
+    level 0 has the smallest cells, and every cell of a level is a union of cells of the level below. A node with an arc to or from another cell of a level is a boundary node of that level.
+    This partition does not depend on the arc weights. Customization then computes, for every cell, the
+    distances between its boundary nodes inside the cell (a clique of shortcuts), level by level: the
+    cells of level 0 search the original arcs, the cells of higher levels search the cliques of their
+    subcells plus the original arcs between them. Cells are independent, so they are processed by several
+    threads, and after weight changes only the cells containing a changed arc are customized again.
+    A query runs a bidirectional Dijkstra in which every node uses the coarsest level whose cell contains
+    neither the source nor the target: it jumps across that cell with the clique and otherwise only
+    follows the arcs leaving the cell.
+*/
+
+#define CRP_FILE_MAGIC 0x31505243   // "CRP1" written at the start of a saved partition
+#define CRP_MAX_LEVELS 4
+
+// Largest cell size of each level, from the finest to the coarsest
+const int crpCellSizes[CRP_MAX_LEVELS] = {1 << 8, 1 << 11, 1 << 14, 1 << 17};
+
+// One level of the overlay. Boundary nodes of cell c are boundary[boundaryOffsets[c] .. boundaryOffsets[c + 1])
+struct CrpLevel {
+    int cellCount;
+    std::vector<int> cell;               // Cell of every node
+    std::vector<int> boundaryOffsets;
+    std::vector<int> boundary;
+    std::vector<int> boundaryIndex;      // Position of every node in the boundary list of its cell, -1 if none
+    std::vector<long long> cliqueOffsets;// Clique of cell c with k boundary nodes: clique[cliqueOffsets[c] + i * k + j]
+    std::vector<int> clique;             // is the distance from boundary node i to boundary node j inside the cell
+};
+
+// The partition and its cliques
+struct CrpOverlay {
+    int nodeCount;
+    std::vector<CrpLevel> levels;        // levels[0] has the smallest cells
+};
+
+// Scratch space of the searches of one customization thread
+struct CrpWorkspace {
+    std::vector<int> dist;
+    std::vector<int> stamp;
+    std::vector<std::pair<int, int> > heap;
+    int round;
+};
+
+/*
+    Function: crpBisect
+    Splits a range of nodes in two with few arcs between the sides. The nodes are ordered breadth-first
+    from a peripheral node, and a minimum cut between the first and the last quarter of that order is
+    found with Dinic's max-flow algorithm on the undirected graph with unit capacities, so both sides
+    keep at least a quarter of the nodes.
+    Parameters:
+        g: The graph.
+        nodes: Node array; nodes[begin .. end) is rearranged so that the first side comes first.
+        begin: First position of the range.
+        end: Position after the range.
+        localId: Scratch array of the graph size filled with -1, restored before returning.
+    Returns:
+        The position where the second side starts.
+    crpBisect complexity: O(sqrt(k) (k + a)) for k nodes and a arcs in the range (unit capacity Dinic).
+*/
+int crpBisect(const Graph& g, std::vector<int>& nodes, int begin, int end, std::vector<int>& localId) {
+    int size = end - begin;
+    for (int k = 0; k < size; k++) {
+        localId[nodes[begin + k]] = k;
+    }
+
+    // Undirected residual graph of the range: every arc becomes a pair of opposite unit capacity arcs
+    std::vector<int> adjOffsets(size + 1, 0);
+    for (int k = 0; k < size; k++) {
+        int u = nodes[begin + k];
+        for (int i = g.offsets[u]; i < g.offsets[u + 1]; i++) {
+            int v = localId[g.arcs[i].target];
+            if (v >= 0 && v != k) {
+                adjOffsets[k + 1]++;
+                adjOffsets[v + 1]++;
+            }
+        }
+    }
+    for (int k = 0; k < size; k++) {
+        adjOffsets[k + 1] += adjOffsets[k];
+    }
+    std::vector<int> adjTarget(adjOffsets[size]);
+    std::vector<int> adjPair(adjOffsets[size]);
+    std::vector<int> capacity(adjOffsets[size], 1);
+    std::vector<int> filled(adjOffsets.begin(), adjOffsets.end() - 1);
+    for (int k = 0; k < size; k++) {
+        int u = nodes[begin + k];
+        for (int i = g.offsets[u]; i < g.offsets[u + 1]; i++) {
+            int v = localId[g.arcs[i].target];
+            if (v >= 0 && v != k) {
+                int forward = filled[k]++;
+                int backward = filled[v]++;
+                adjTarget[forward] = v;
+                adjTarget[backward] = k;
+                adjPair[forward] = backward;
+                adjPair[backward] = forward;
+            }
+        }
+    }
+
+    // Breadth-first order from a peripheral node (the last one reached from node 0), all components included
+    std::vector<int> level(size, -1);
+    std::vector<int> order;
+    order.reserve(size);
+    int peripheral = 0;
+    for (int pass = 0; pass < 2; pass++) {
+        std::fill(level.begin(), level.end(), -1);
+        order.clear();
+        for (int k = 0; k < size; k++) {
+            int root = k == 0 ? peripheral : k;
+            if (level[root] != -1) {
+                continue;
+            }
+            level[root] = 0;
+            order.push_back(root);
+            for (size_t head = order.size() - 1; head < order.size(); head++) {
+                int u = order[head];
+                for (int e = adjOffsets[u]; e < adjOffsets[u + 1]; e++) {
+                    if (level[adjTarget[e]] == -1) {
+                        level[adjTarget[e]] = level[u] + 1;
+                        order.push_back(adjTarget[e]);
+                    }
+                }
+            }
+            if (pass == 0) {
+                peripheral = order.back();
+                break;
+            }
+        }
+    }
+    std::vector<char> side(size, 0);   // 1: source quarter, 2: sink quarter
+    int quarter = size / 4;
+    for (int k = 0; k < quarter; k++) {
+        side[order[k]] = 1;
+        side[order[size - 1 - k]] = 2;
+    }
+
+    // Dinic: breadth-first levels from the sources, then blocking flow by depth-first search
+    std::vector<int> next(size);
+    std::vector<int> queue;
+    std::vector<int> path;
+    std::vector<int> pathArcs;
+    while (true) {
+        std::fill(level.begin(), level.end(), -1);
+        queue.clear();
+        for (int k = 0; k < size; k++) {
+            if (side[k] == 1) {
+                level[k] = 0;
+                queue.push_back(k);
+            }
+        }
+        bool sinkReached = false;
+        for (size_t head = 0; head < queue.size(); head++) {
+            int u = queue[head];
+            for (int e = adjOffsets[u]; e < adjOffsets[u + 1]; e++) {
+                int v = adjTarget[e];
+                if (capacity[e] > 0 && level[v] == -1) {
+                    level[v] = level[u] + 1;
+                    sinkReached |= side[v] == 2;
+                    queue.push_back(v);
+                }
+            }
+        }
+        if (!sinkReached) {
+            break;
+        }
+
+        for (int k = 0; k < size; k++) {
+            next[k] = adjOffsets[k];
+        }
+        for (int s = 0; s < size; s++) {
+            if (side[s] != 1) {
+                continue;
+            }
+            path.assign(1, s);
+            pathArcs.clear();
+            while (!path.empty()) {
+                int u = path.back();
+                if (side[u] == 2) {
+                    for (size_t k = 0; k < pathArcs.size(); k++) {
+                        capacity[pathArcs[k]]--;
+                        capacity[adjPair[pathArcs[k]]]++;
+                    }
+                    path.assign(1, s);
+                    pathArcs.clear();
+                    continue;
+                }
+                while (next[u] < adjOffsets[u + 1] &&
+                       (capacity[next[u]] == 0 || level[adjTarget[next[u]]] != level[u] + 1)) {
+                    next[u]++;
+                }
+                if (next[u] == adjOffsets[u + 1]) {
+                    level[u] = -1;  // Dead end for the rest of this phase
+                    path.pop_back();
+                    if (!pathArcs.empty()) {
+                        pathArcs.pop_back();
+                    }
+                } else {
+                    pathArcs.push_back(next[u]);
+                    path.push_back(adjTarget[next[u]]);
+                }
+            }
+        }
+    }
+
+    // The first side is everything still reachable from the sources in the residual graph
+    std::fill(level.begin(), level.end(), -1);
+    queue.clear();
+    for (int k = 0; k < size; k++) {
+        if (side[k] == 1) {
+            level[k] = 0;
+            queue.push_back(k);
+        }
+    }
+    for (size_t head = 0; head < queue.size(); head++) {
+        int u = queue[head];
+        for (int e = adjOffsets[u]; e < adjOffsets[u + 1]; e++) {
+            if (capacity[e] > 0 && level[adjTarget[e]] == -1) {
+                level[adjTarget[e]] = 0;
+                queue.push_back(adjTarget[e]);
+            }
+        }
+    }
+
+    std::vector<int> rearranged;
+    rearranged.reserve(size);
+    for (int k = 0; k < size; k++) {
+        if (level[k] == 0) {
+            rearranged.push_back(nodes[begin + k]);
+        }
+    }
+    int middle = begin + rearranged.size();
+    for (int k = 0; k < size; k++) {
+        if (level[k] != 0) {
+            rearranged.push_back(nodes[begin + k]);
+        }
+    }
+    for (int k = 0; k < size; k++) {
+        nodes[begin + k] = rearranged[k];
+        localId[rearranged[k]] = -1;
+    }
+    return middle;
+}
+
+/*
+    Function: computeCrpPartition
+    Assigns every node its cell on every level. The nodes are bisected recursively with crpBisect until
+    the parts fit the smallest cell size; the cells of a level are the largest parts of that recursion
+    that fit the level's cell size, so the levels are nested. Levels whose cell size holds the whole
+    graph are left out.
+    Parameters:
+        g: The graph.
+    Returns:
+        The overlay with cell ids set and no boundaries or cliques yet.
+    computeCrpPartition complexity: O(log n * sqrt(n) (n + m)) in the worst case, seconds on road graphs.
+*/
+CrpOverlay computeCrpPartition(const Graph& g) {
+    int n = g.nodeCount;
+    std::vector<int> nodes(n);
+    for (int v = 0; v < n; v++) {
+        nodes[v] = v;
+    }
+    std::vector<int> localId(n, -1);
+
+    // Parts of the recursion as ranges of nodes; every part lies inside the range of its parent
+    std::vector<std::pair<int, int> > parts;
+    std::vector<int> parent;
+    parts.push_back(std::make_pair(0, n));
+    parent.push_back(-1);
+    for (size_t p = 0; p < parts.size(); p++) {
+        int begin = parts[p].first;
+        int end = parts[p].second;
+        if (end - begin <= crpCellSizes[0]) {
+            continue;
+        }
+        int middle = crpBisect(g, nodes, begin, end, localId);
+        parts.push_back(std::make_pair(begin, middle));
+        parent.push_back(p);
+        parts.push_back(std::make_pair(middle, end));
+        parent.push_back(p);
+    }
+
+    CrpOverlay overlay;
+    overlay.nodeCount = n;
+    for (int l = 0; l < CRP_MAX_LEVELS && n > crpCellSizes[l]; l++) {
+        CrpLevel level;
+        level.cellCount = 0;
+        level.cell.resize(n);
+        for (size_t p = 0; p < parts.size(); p++) {
+            int size = parts[p].second - parts[p].first;
+            int parentSize = parent[p] >= 0 ? parts[parent[p]].second - parts[parent[p]].first : INF;
+            if (size <= crpCellSizes[l] && parentSize > crpCellSizes[l]) {
+                for (int k = parts[p].first; k < parts[p].second; k++) {
+                    level.cell[nodes[k]] = level.cellCount;
+                }
+                level.cellCount++;
+            }
+        }
+        overlay.levels.push_back(level);
+    }
+    return overlay;
+}
+
+/*
+    Function: buildCrpTopology
+    Finds the boundary nodes of every cell and lays out the clique matrices, which start out unreachable.
+    Parameters:
+        g: The graph the partition belongs to.
+        overlay: The partition; its boundary and clique arrays are (re)built.
+    buildCrpTopology complexity: O(L (n + m) + sum of k^2) for L levels and cells with k boundary nodes.
+*/
+void buildCrpTopology(const Graph& g, CrpOverlay& overlay) {
+    if (overlay.nodeCount != g.nodeCount) {
+        throw std::runtime_error("Partition file does not match the graph");
+    }
+    int n = g.nodeCount;
+    for (size_t l = 0; l < overlay.levels.size(); l++) {
+        CrpLevel& level = overlay.levels[l];
+        std::vector<char> isBoundary(n, 0);
+        for (int u = 0; u < n; u++) {
+            for (int i = g.offsets[u]; i < g.offsets[u + 1]; i++) {
+                int v = g.arcs[i].target;
+                if (level.cell[u] != level.cell[v]) {
+                    isBoundary[u] = 1;
+                    isBoundary[v] = 1;
+                }
+            }
+        }
+
+        level.boundaryOffsets.assign(level.cellCount + 1, 0);
+        for (int v = 0; v < n; v++) {
+            level.boundaryOffsets[level.cell[v] + 1] += isBoundary[v];
+        }
+        for (int c = 0; c < level.cellCount; c++) {
+            level.boundaryOffsets[c + 1] += level.boundaryOffsets[c];
+        }
+        level.boundary.resize(level.boundaryOffsets[level.cellCount]);
+        level.boundaryIndex.assign(n, -1);
+        std::vector<int> filled(level.boundaryOffsets.begin(), level.boundaryOffsets.end() - 1);
+        for (int v = 0; v < n; v++) {
+            if (isBoundary[v]) {
+                int c = level.cell[v];
+                level.boundaryIndex[v] = filled[c] - level.boundaryOffsets[c];
+                level.boundary[filled[c]++] = v;
+            }
+        }
+
+        level.cliqueOffsets.assign(level.cellCount + 1, 0);
+        for (int c = 0; c < level.cellCount; c++) {
+            long long k = level.boundaryOffsets[c + 1] - level.boundaryOffsets[c];
+            level.cliqueOffsets[c + 1] = level.cliqueOffsets[c] + k * k;
+        }
+        level.clique.assign(level.cliqueOffsets[level.cellCount], INF);
+    }
+}
+
+/*
+    Function: saveCrpPartition
+    Writes the cell ids of every level to a binary file. Boundaries and cliques are derived again
+    from the graph when the partition is used.
+    Parameters:
+        overlay: The partition to save.
+        path: Destination file.
+    saveCrpPartition complexity: O(L n).
+*/
+void saveCrpPartition(const CrpOverlay& overlay, const char* path) {
+    std::ofstream out(path, std::ios::binary);
+    if (!out) {
+        throw std::runtime_error(std::string("Cannot open partition file for writing: ") + path);
+    }
+    int header[3] = {CRP_FILE_MAGIC, overlay.nodeCount, (int)overlay.levels.size()};
+    out.write((const char*)header, sizeof(header));
+    for (size_t l = 0; l < overlay.levels.size(); l++) {
+        out.write((const char*)&overlay.levels[l].cellCount, sizeof(int));
+        out.write((const char*)overlay.levels[l].cell.data(), overlay.levels[l].cell.size() * sizeof(int));
+    }
+    if (!out) {
+        throw std::runtime_error(std::string("Failed to write partition file: ") + path);
+    }
+}
+
+/*
+    Function: loadCrpPartition
+    Reads a partition written by saveCrpPartition.
+    Parameters:
+        path: Source file.
+    Returns:
+        The overlay with cell ids set; call buildCrpTopology before customizing it.
+    loadCrpPartition complexity: O(L n).
+*/
+CrpOverlay loadCrpPartition(const char* path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        throw std::runtime_error(std::string("Cannot open partition file: ") + path);
+    }
+    int header[3];
+    in.read((char*)header, sizeof(header));
+    if (!in || header[0] != CRP_FILE_MAGIC || header[2] < 0 || header[2] > CRP_MAX_LEVELS) {
+        throw std::runtime_error(std::string("Not a partition file: ") + path);
+    }
+    CrpOverlay overlay;
+    overlay.nodeCount = header[1];
+    overlay.levels.resize(header[2]);
+    for (size_t l = 0; l < overlay.levels.size(); l++) {
+        CrpLevel& level = overlay.levels[l];
+        in.read((char*)&level.cellCount, sizeof(int));
+        level.cell.resize(overlay.nodeCount);
+        in.read((char*)level.cell.data(), level.cell.size() * sizeof(int));
+        if (!in) {
+            break;
+        }
+        for (int v = 0; v < overlay.nodeCount; v++) {
+            if (level.cell[v] < 0 || level.cell[v] >= level.cellCount) {
+                throw std::runtime_error(std::string("Corrupt partition file: ") + path);
+            }
+        }
+    }
+    if (!in) {
+        throw std::runtime_error(std::string("Truncated partition file: ") + path);
+    }
+    return overlay;
+}
+
+/*
+    Function: customizeCrpCell
+    Computes the clique of one cell with one Dijkstra search per boundary node, restricted to the cell.
+    On level 0 the searches follow the original arcs; on higher levels they run on the boundary nodes
+    of the level below, following the cliques of the subcells and the original arcs between subcells.
+    Parameters:
+        g: The graph with the current weights.
+        overlay: The overlay; the cliques of the level below must be up to date.
+        l: The level of the cell.
+        c: The cell.
+        ws: Scratch space of the calling thread.
+    customizeCrpCell complexity: O(k (a + s log s)) for k boundary nodes and searches settling s nodes
+    over a arcs.
+*/
+void customizeCrpCell(const Graph& g, CrpOverlay& overlay, int l, int c, CrpWorkspace& ws) {
+    CrpLevel& level = overlay.levels[l];
+    const CrpLevel* lower = l > 0 ? &overlay.levels[l - 1] : NULL;
+    int first = level.boundaryOffsets[c];
+    int k = level.boundaryOffsets[c + 1] - first;
+    int* clique = &level.clique[level.cliqueOffsets[c]];
+
+    for (int i = 0; i < k; i++) {
+        ws.round++;
+        ws.heap.clear();
+        int source = level.boundary[first + i];
+        ws.dist[source] = 0;
+        ws.stamp[source] = ws.round;
+        ws.heap.push_back(std::make_pair(0, source));
+        int remaining = k;
+        while (!ws.heap.empty() && remaining > 0) {
+            std::pop_heap(ws.heap.begin(), ws.heap.end(), std::greater<std::pair<int, int> >());
+            int d = ws.heap.back().first;
+            int u = ws.heap.back().second;
+            ws.heap.pop_back();
+            if (d > ws.dist[u]) {
+                continue;  // Stale heap entry
+            }
+            remaining -= level.boundaryIndex[u] >= 0;
+
+            if (lower != NULL) {
+                // Jump across the subcell of u
+                int sub = lower->cell[u];
+                int subFirst = lower->boundaryOffsets[sub];
+                int subCount = lower->boundaryOffsets[sub + 1] - subFirst;
+                const int* row = &lower->clique[lower->cliqueOffsets[sub] + (long long)lower->boundaryIndex[u] * subCount];
+                for (int j = 0; j < subCount; j++) {
+                    int v = lower->boundary[subFirst + j];
+                    if (row[j] < INF && (ws.stamp[v] != ws.round || d + row[j] < ws.dist[v])) {
+                        ws.stamp[v] = ws.round;
+                        ws.dist[v] = d + row[j];
+                        ws.heap.push_back(std::make_pair(ws.dist[v], v));
+                        std::push_heap(ws.heap.begin(), ws.heap.end(), std::greater<std::pair<int, int> >());
+                    }
+                }
+            }
+            for (int a = g.offsets[u]; a < g.offsets[u + 1]; a++) {
+                int v = g.arcs[a].target;
+                if (level.cell[v] != c || (lower != NULL && lower->cell[v] == lower->cell[u])) {
+                    continue;  // Leaves the cell, or is covered by the clique of the subcell
+                }
+                int nd = d + g.arcs[a].weight;
+                if (ws.stamp[v] != ws.round || nd < ws.dist[v]) {
+                    ws.stamp[v] = ws.round;
+                    ws.dist[v] = nd;
+                    ws.heap.push_back(std::make_pair(nd, v));
+                    std::push_heap(ws.heap.begin(), ws.heap.end(), std::greater<std::pair<int, int> >());
+                }
+            }
+        }
+        for (int j = 0; j < k; j++) {
+            int v = level.boundary[first + j];
+            clique[(long long)i * k + j] = ws.stamp[v] == ws.round ? ws.dist[v] : INF;
+        }
+    }
+}
+
+/*
+    Function: customizeCrp
+    Recomputes the cliques level by level, distributing the cells of each level over a pool of threads.
+    Parameters:
+        g: The graph with the current weights.
+        overlay: The overlay to customize.
+        threadCount: Number of worker threads.
+        dirty: Cells to recompute per level (non-zero entries), or NULL to recompute every cell.
+    Returns:
+        The number of cells customized.
+    customizeCrp complexity: The sum of customizeCrpCell over the selected cells, divided among the threads.
+*/
+long long customizeCrp(const Graph& g, CrpOverlay& overlay, int threadCount,
+                       const std::vector<std::vector<char> >* dirty) {
+    long long customized = 0;
+    for (size_t l = 0; l < overlay.levels.size(); l++) {
+        std::vector<int> cells;
+        for (int c = 0; c < overlay.levels[l].cellCount; c++) {
+            if (dirty == NULL || (*dirty)[l][c]) {
+                cells.push_back(c);
+            }
+        }
+        std::atomic<size_t> next(0);
+        runInParallel(std::min(threadCount, std::max(1, (int)cells.size())), [&](int) {
+            CrpWorkspace ws;
+            ws.dist.assign(g.nodeCount, INF);
+            ws.stamp.assign(g.nodeCount, 0);
+            ws.round = 0;
+            for (size_t k = next++; k < cells.size(); k = next++) {
+                customizeCrpCell(g, overlay, l, cells[k], ws);
+            }
+        });
+        customized += cells.size();
+    }
+    return customized;
+}
+
+/*
+    Function: crpQueryLevel
+    Finds the level on which a node is searched during an s-t query: the coarsest level whose cell of
+    the node contains neither s nor t, or -1 if the node shares its level-0 cell with s or t and must
+    follow the original arcs.
+    Parameters:
+        overlay: The overlay.
+        v: The node.
+        source: Source of the query.
+        target: Target of the query.
+    Returns:
+        The search level of v.
+    crpQueryLevel complexity: O(L).
+*/
+inline int crpQueryLevel(const CrpOverlay& overlay, int v, int source, int target) {
+    for (int l = (int)overlay.levels.size() - 1; l >= 0; l--) {
+        const std::vector<int>& cell = overlay.levels[l].cell;
+        if (cell[v] != cell[source] && cell[v] != cell[target]) {
+            return l;
+        }
+    }
+    return -1;
+}
+
+/*
+    Function: crpSearchStep
+    Settles the next node of one direction of the overlay query and relaxes its arcs on its search
+    level: the clique of its cell and the arcs leaving the cell, or all original arcs.
+    Parameters:
+        g: Graph of the direction (the reverse graph for the backward search).
+        overlay: The customized overlay.
+        forward: True for the forward direction; the backward one reads the cliques transposed.
+        heap, dist, stamp: The state of the searching direction.
+        otherDist, otherStamp: The state of the opposite direction, used to detect meeting nodes.
+        round: The current query round.
+        source, target: The query.
+        best: Shortest distance found so far, updated in place.
+    crpSearchStep complexity: O((k + d) log h) for a clique of k nodes, d arcs and a heap of size h.
+*/
+void crpSearchStep(const Graph& g, const CrpOverlay& overlay, bool forward,
+                   std::vector<std::pair<int, int> >& heap, std::vector<int>& dist, std::vector<int>& stamp,
+                   const std::vector<int>& otherDist, const std::vector<int>& otherStamp,
+                   int round, int source, int target, int& best) {
+    std::pop_heap(heap.begin(), heap.end(), std::greater<std::pair<int, int> >());
+    int d = heap.back().first;
+    int u = heap.back().second;
+    heap.pop_back();
+    if (d > dist[u]) {
+        return;  // Stale heap entry
+    }
+
+    int l = crpQueryLevel(overlay, u, source, target);
+    const CrpLevel* level = l >= 0 ? &overlay.levels[l] : NULL;
+    int cellFirst = 0;
+    int cellCount = 0;
+    int i = 0;
+    const int* clique = NULL;
+    if (level != NULL) {
+        // u entered this cell through an arc crossing its border, so it is one of its boundary nodes
+        int c = level->cell[u];
+        cellFirst = level->boundaryOffsets[c];
+        cellCount = level->boundaryOffsets[c + 1] - cellFirst;
+        clique = &level->clique[level->cliqueOffsets[c]];
+        i = level->boundaryIndex[u];
+    }
+
+    for (int j = 0; j < cellCount; j++) {
+        int w = forward ? clique[(long long)i * cellCount + j] : clique[(long long)j * cellCount + i];
+        int v = level->boundary[cellFirst + j];
+        int nd = d + w;
+        if (w < INF && (stamp[v] != round || nd < dist[v])) {
+            stamp[v] = round;
+            dist[v] = nd;
+            heap.push_back(std::make_pair(nd, v));
+            std::push_heap(heap.begin(), heap.end(), std::greater<std::pair<int, int> >());
+            if (otherStamp[v] == round && nd + otherDist[v] < best) {
+                best = nd + otherDist[v];
+            }
+        }
+    }
+    for (int a = g.offsets[u]; a < g.offsets[u + 1]; a++) {
+        int v = g.arcs[a].target;
+        if (level != NULL && level->cell[v] == level->cell[u]) {
+            continue;  // Inside the cell: covered by the clique
+        }
+        int nd = d + g.arcs[a].weight;
+        if (stamp[v] != round || nd < dist[v]) {
+            stamp[v] = round;
+            dist[v] = nd;
+            heap.push_back(std::make_pair(nd, v));
+            std::push_heap(heap.begin(), heap.end(), std::greater<std::pair<int, int> >());
+            if (otherStamp[v] == round && nd + otherDist[v] < best) {
+                best = nd + otherDist[v];
+            }
+        }
+    }
+}
+
+/*
+    Function: crpQuery
+    Answers a point-to-point distance query with a bidirectional search over the overlay, always
+    advancing the direction with the smaller queue key until the two keys add up to the best distance.
+    Parameters:
+        g: The graph with the weights the overlay was customized for.
+        reverse: The reverse graph of g.
+        overlay: The customized overlay.
+        state: Reusable query scratch space.
+        source: Start node.
+        target: Destination node.
+    Returns:
+        The shortest distance from source to target, or INF if unreachable.
+    crpQuery complexity: O(k log k) for k nodes searched, a few thousand on road graphs.
+*/
+int crpQuery(const Graph& g, const Graph& reverse, const CrpOverlay& overlay, ChQueryState& state,
+             int source, int target) {
+    state.round++;
+    state.heapF.clear();
+    state.heapB.clear();
+    state.distF[source] = 0;
+    state.stampF[source] = state.round;
+    state.heapF.push_back(std::make_pair(0, source));
+    state.distB[target] = 0;
+    state.stampB[target] = state.round;
+    state.heapB.push_back(std::make_pair(0, target));
+
+    int best = source == target ? 0 : INF;
+    while (true) {
+        int topF = state.heapF.empty() ? INF : state.heapF.front().first;
+        int topB = state.heapB.empty() ? INF : state.heapB.front().first;
+        if (topF + topB >= best) {
+            break;
+        }
+        if (topF <= topB) {
+            crpSearchStep(g, overlay, true, state.heapF, state.distF, state.stampF, state.distB, state.stampB,
+                          state.round, source, target, best);
+        } else {
+            crpSearchStep(reverse, overlay, false, state.heapB, state.distB, state.stampB, state.distF, state.stampF,
+                          state.round, source, target, best);
+        }
+    }
+    return best;
+}
+
+/*
+    ALT (A*, Landmarks, Triangle inequality)
+    A few landmark nodes are chosen during preprocessing and the distances from and to every landmark are
+    stored for all nodes. For a target t and landmark L the triangle inequality gives the lower bounds
+    d(v, t) >= d(v, L) - d(t, L) and d(v, t) >= d(L, t) - d(L, v). Their maximum over all landmarks is a
+    consistent potential, so A* with it settles every node at most once while being pulled towards t.
+*/
+
+#define ALT_FILE_MAGIC 0x31544c41   // "ALT1" written at the start of a saved landmark table
+
+// Landmark distance tables, stored node-major so that the potential of a node reads one contiguous block
+struct AltIndex {
+    int nodeCount;
+    int landmarkCount;
+    std::vector<int> landmarks;      // Landmark node ids
+    std::vector<int> fromLandmark;   // fromLandmark[v * landmarkCount + i] = d(landmark i, v)
+    std::vector<int> toLandmark;     // toLandmark[v * landmarkCount + i] = d(v, landmark i)
+};
+
+/*
+    Function: altSelectAvoid
+    Chooses the next landmark with the "avoid" heuristic: in the shortest path tree of a root node, every
+    node is weighted by how much the current landmarks underestimate its distance from the root; the
+    subtree with the largest total weight that contains no landmark is followed down to a leaf, which
+    becomes the new landmark because the current bounds are worst in that region.
+    Parameters:
+        g: The graph.
+        state: Search state holding the shortest path tree of root.
+        root: Root of the tree.
+        index: The landmarks chosen so far with their tables.
+    Returns:
+        The new landmark, or -1 if no suitable node exists.
+    altSelectAvoid complexity: O(n log n).
+*/
+int altSelectAvoid(const Graph& g, const SearchState& state, int root, const AltIndex& index) {
+    int n = g.nodeCount;
+    int k = index.landmarkCount;
+    std::vector<int> order;
+    for (int v = 0; v < n; v++) {
+        if (searchDistance(state, v) < INF) {
+            order.push_back(v);
+        }
+    }
+    // Children before parents: decreasing distance from the root
+    std::sort(order.begin(), order.end(), [&](int a, int b) { return state.dist[a] > state.dist[b]; });
+
+    std::vector<long long> size(n, 0);
+    std::vector<bool> hasLandmark(n, false);
+    for (int i = 0; i < k; i++) {
+        hasLandmark[index.landmarks[i]] = true;
+    }
+    for (size_t j = 0; j < order.size(); j++) {
+        int v = order[j];
+        long long bound = 0;
+        for (int i = 0; i < k; i++) {
+            int fromL = index.fromLandmark[(size_t)root * k + i];
+            int toL = index.fromLandmark[(size_t)v * k + i];
+            if (fromL < INF && toL < INF) {
+                bound = std::max(bound, (long long)toL - fromL);
+            }
+        }
+        size[v] += state.dist[v] - bound;
+        if (hasLandmark[v]) {
+            size[v] = 0;
+        }
+        int parent = state.pred[v];
+        if (parent != -1) {
+            if (hasLandmark[v]) {
+                hasLandmark[parent] = true;
+            }
+            size[parent] += size[v];
+        }
+    }
+
+    // Walk down from the root along the heaviest landmark-free subtree
+    int best = -1;
+    long long bestSize = 0;
+    for (size_t j = 0; j < order.size(); j++) {
+        if (size[order[j]] > bestSize && !hasLandmark[order[j]]) {
+            bestSize = size[order[j]];
+            best = order[j];
+        }
+    }
+    if (best == -1) {
+        return -1;
+    }
+    while (true) {
+        int next = -1;
+        for (int i = g.offsets[best]; i < g.offsets[best + 1]; i++) {
+            int c = g.arcs[i].target;
+            if (state.pred[c] == best && searchDistance(state, c) < INF && c != root &&
+                (next == -1 || size[c] > size[next])) {
+                next = c;
+            }
+        }
+        if (next == -1 || size[next] == 0) {
+            return best;
+        }
+        best = next;
+    }
+}
+
+/*
+    Function: buildAltIndex
+    Selects landmarks and computes their distance tables with the existing Dijkstra, run forward on the
+    graph (distances from a landmark) and on the reverse graph (distances to a landmark).
+    The first landmark is the node farthest from a random start. Further landmarks are either the node
+    farthest from all chosen landmarks ("farthest") or picked with altSelectAvoid ("avoid").
+    Parameters:
+        g: The graph.
+        landmarkCount: Number of landmarks to select.
+        useAvoid: True for the avoid heuristic, false for farthest.
+    Returns:
+        The landmark tables.
+    buildAltIndex complexity: O(k (n + m) log n) for k landmarks (plus O(k n log n) for avoid).
+*/
+AltIndex buildAltIndex(const Graph& g, int landmarkCount, bool useAvoid) {
+    int n = g.nodeCount;
+    Graph reverse = buildReverseGraph(g);
+    SearchState state;
+    initSearchState(state, n);
+
+    AltIndex index;
+    index.nodeCount = n;
+    index.landmarkCount = 0;
+
+    std::vector<int> chosen;
+    std::vector<long long> closest(n, -1);  // Smallest distance from a chosen landmark, -1 if unreached
+    unsigned seed = 12345;
+    int start = -1;
+    for (int attempt = 0; attempt < 100 && start == -1; attempt++) {
+        seed = seed * 1103515245 + 12345;
+        int candidate = (seed >> 8) % std::max(1, n);
+        if (candidate < n && g.offsets[candidate + 1] > g.offsets[candidate]) {
+            start = candidate;
+        }
+    }
+    if (start == -1) {
+        freeSearchState(state);
+        freeGraph(reverse);
+        throw std::runtime_error("Graph has no arcs to select landmarks from");
+    }
+
+    std::vector<std::vector<int> > fromTables, toTables;
+    while ((int)chosen.size() < landmarkCount) {
+        int next = -1;
+        if (chosen.empty()) {
+            dijkstra(g, state, start, -1);
+            int farthestDist = -1;
+            for (int v = 0; v < n; v++) {
+                int d = searchDistance(state, v);
+                if (d < INF && d > farthestDist) {
+                    farthestDist = d;
+                    next = v;
+                }
+            }
+        } else if (useAvoid) {
+            // Root: a random node, alternating with the node farthest from all landmarks
+            int root = start;
+            if (chosen.size() % 2 == 0) {
+                long long far = -1;
+                for (int v = 0; v < n; v++) {
+                    if (closest[v] > far) {
+                        far = closest[v];
+                        root = v;
+                    }
+                }
+            } else {
+                seed = seed * 1103515245 + 12345;
+                root = (seed >> 8) % n;
+            }
+            dijkstra(g, state, root, -1);
+            next = altSelectAvoid(g, state, root, index);
+        } else {
+            long long far = -1;
+            for (int v = 0; v < n; v++) {
+                if (closest[v] > far) {
+                    far = closest[v];
+                    next = v;
+                }
+            }
+        }
+        if (next == -1 || std::find(chosen.begin(), chosen.end(), next) != chosen.end()) {
+            break;  // No further useful landmark
+        }
+        chosen.push_back(next);
+
+        std::vector<int> fromL(n), toL(n);
+        dijkstra(g, state, next, -1);
+        for (int v = 0; v < n; v++) {
+            fromL[v] = searchDistance(state, v);
+            if (fromL[v] < INF && (closest[v] == -1 || fromL[v] < closest[v])) {
+                closest[v] = fromL[v];
+            }
+        }
+        closest[next] = 0;
+        dijkstra(reverse, state, next, -1);
+        for (int v = 0; v < n; v++) {
+            toL[v] = searchDistance(state, v);
+        }
+        fromTables.push_back(fromL);
+        toTables.push_back(toL);
+
+        // Rebuild the node-major tables with the new landmark
+        int k = chosen.size();
+        index.landmarkCount = k;
+        index.landmarks = chosen;
+        index.fromLandmark.resize((size_t)n * k);
+        index.toLandmark.resize((size_t)n * k);
+        for (int v = 0; v < n; v++) {
+            for (int i = 0; i < k; i++) {
+                index.fromLandmark[(size_t)v * k + i] = fromTables[i][v];
+                index.toLandmark[(size_t)v * k + i] = toTables[i][v];
+            }
+        }
+    }
+
+    freeSearchState(state);
+    freeGraph(reverse);
+    return index;
+}
+
+/*
+    Function: saveAltIndex
+    Writes landmark tables to a binary file.
+    Parameters:
+        index: The tables to save.
+        path: Destination file.
+    saveAltIndex complexity: O(k n).
+*/
+void saveAltIndex(const AltIndex& index, const char* path) {
+    std::ofstream out(path, std::ios::binary);
+    if (!out) {
+        throw std::runtime_error(std::string("Cannot open landmark file for writing: ") + path);
+    }
+    int header[3] = {ALT_FILE_MAGIC, index.nodeCount, index.landmarkCount};
+    out.write((const char*)header, sizeof(header));
+    out.write((const char*)index.landmarks.data(), index.landmarks.size() * sizeof(int));
+    out.write((const char*)index.fromLandmark.data(), index.fromLandmark.size() * sizeof(int));
+    out.write((const char*)index.toLandmark.data(), index.toLandmark.size() * sizeof(int));
+    if (!out) {
+        throw std::runtime_error(std::string("Failed to write landmark file: ") + path);
+    }
+}
+
+/*
+    Function: loadAltIndex
+    Reads landmark tables written by saveAltIndex.
+    Parameters:
+        path: Source file.
+    Returns:
+        The landmark tables.
+    loadAltIndex complexity: O(k n).
+*/
+AltIndex loadAltIndex(const char* path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        throw std::runtime_error(std::string("Cannot open landmark file: ") + path);
+    }
+    int header[3];
+    in.read((char*)header, sizeof(header));
+    if (!in || header[0] != ALT_FILE_MAGIC) {
+        throw std::runtime_error(std::string("Not a landmark file: ") + path);
+    }
+    AltIndex index;
+    index.nodeCount = header[1];
+    index.landmarkCount = header[2];
+    index.landmarks.resize(index.landmarkCount);
+    index.fromLandmark.resize((size_t)index.nodeCount * index.landmarkCount);
+    index.toLandmark.resize((size_t)index.nodeCount * index.landmarkCount);
+    in.read((char*)index.landmarks.data(), index.landmarks.size() * sizeof(int));
+    in.read((char*)index.fromLandmark.data(), index.fromLandmark.size() * sizeof(int));
+    in.read((char*)index.toLandmark.data(), index.toLandmark.size() * sizeof(int));
+    if (!in) {
+        throw std::runtime_error(std::string("Truncated landmark file: ") + path);
+    }
+    return index;
+}
+
+/*
+    Function: altPotential
+    Computes the landmark lower bound on the distance from v to the target. If the target reaches a
+    landmark that v does not, v cannot reach the target either; returning INF then (rather than ignoring
+    the landmark) keeps the potential consistent, so A* never has to settle a node twice.
+    Parameters:
+        index: The landmark tables.
+        v: The node to evaluate.
+        target: The destination node.
+    Returns:
+        A lower bound on d(v, target), or INF if v cannot reach the target.
+    altPotential complexity: O(k) for k landmarks.
+*/
+inline int altPotential(const AltIndex& index, int v, int target) {
+    int k = index.landmarkCount;
+    const int* fromV = &index.fromLandmark[(size_t)v * k];
+    const int* toV = &index.toLandmark[(size_t)v * k];
+    const int* fromT = &index.fromLandmark[(size_t)target * k];
+    const int* toT = &index.toLandmark[(size_t)target * k];
+    int bound = 0;
+    for (int i = 0; i < k; i++) {
+        if (toT[i] < INF) {
+            if (toV[i] == INF) {
+                return INF;  // t reaches L but v does not, so v does not reach t
+            }
+            bound = std::max(bound, toV[i] - toT[i]);       // d(v, t) >= d(v, L) - d(t, L)
+        }
+        if (fromT[i] < INF && fromV[i] < INF) {
+            bound = std::max(bound, fromT[i] - fromV[i]);   // d(v, t) >= d(L, t) - d(L, v)
+        }
+    }
+    return bound;
+}
+
+/*
+    Function: altQuery
+    Answers a point-to-point query with A* search guided by the landmark potential. Queue keys are
+    dist + potential, so they are kept in a 4-ary heap that stores keys next to the nodes.
+    Parameters:
+        g: The graph.
+        index: The landmark tables of g.
+        state: Search state receiving distances and predecessors.
+        source: The start node.
+        target: The destination node.
+        settled: Receives the number of settled nodes.
+    Returns:
+        The distance from source to target, or INF if unreachable.
+    altQuery complexity: O((n + m) log n) in the worst case, usually a small fraction of the graph.
+*/
+int altQuery(const Graph& g, const AltIndex& index, SearchState& state, int source, int target, long long& settled) {
+    beginSearch(state);
+    DAryHeapQueue<4> queue(state);
+    queue.clear();
+    settled = 0;
+    touch(state, source);
+    state.dist[source] = 0;
+    int sourcePotential = altPotential(index, source, target);
+    if (sourcePotential == INF) {
+        return INF;
+    }
+    queue.push(source, sourcePotential);
+
+    int* dist = state.dist;
+    while (!queue.empty()) {
+        int u = queue.pop();
+        if (state.heapPos[u] == SETTLED) {
+            continue;
+        }
+        state.heapPos[u] = SETTLED;
+        settled++;
+        if (u == target) {
+            return dist[u];
+        }
+        for (int i = g.offsets[u]; i < g.offsets[u + 1]; i++) {
+            int v = g.arcs[i].target;
+            touch(state, v);
+            if (state.heapPos[v] == SETTLED) {
+                continue;  // push would take SETTLED for a heap position
+            }
+            int nd = dist[u] + g.arcs[i].weight;
+            if (nd < dist[v]) {
+                int potential = altPotential(index, v, target);
+                if (potential == INF) {
+                    continue;  // v cannot reach the target
+                }
+                dist[v] = nd;
+                state.pred[v] = u;
+                queue.push(v, nd + potential);
+            }
+        }
+    }
+    return INF;
+}
+
+/*
+    Arc-flags
+    The nodes are split into k regions (recursive minimum cut bisection, as for CRP) and every arc gets a
+    k-bit flag word: bit r is set if the arc lies on some shortest path to a node of region r. Arcs inside
+    a region get its bit directly; for the other arcs, a backward Dijkstra from every entry node of the
+    region (a node of r with an arc coming from another region) marks the arcs (u, v) with
+    d(u) = w(u, v) + d(v). A query is a Dijkstra that only relaxes arcs flagged for the target's region,
+    which keeps it close to the shortest path once it leaves the source's neighbourhood.
+*/
+
+#define AF_FILE_MAGIC 0x31474641    // "AFG1" written at the start of a saved arc-flag table
+#define AF_MAX_REGIONS 64           // One 64-bit flag word per arc
+
+// Regions and flags; flags[i] belongs to arc i of the CSR graph they were computed for
+struct ArcFlags {
+    int nodeCount;
+    int arcCount;
+    int regionCount;
+    std::vector<int> region;        // Region of every node
+    std::vector<uint64_t> flags;    // Bit r of flags[i]: arc i starts some shortest path into region r
+};
+
+/*
+    Function: computeRegions
+    Splits the nodes into regions by repeatedly bisecting the largest region with crpBisect.
+    Parameters:
+        g: The graph.
+        regionCount: Number of regions wanted; fewer are returned if the regions become too small to split.
+    Returns:
+        The region of every node, numbered from 0.
+    computeRegions complexity: O(k sqrt(n) (n + m)) in the worst case for k regions.
+*/
+std::vector<int> computeRegions(const Graph& g, int regionCount) {
+    int n = g.nodeCount;
+    std::vector<int> nodes(n);
+    for (int v = 0; v < n; v++) {
+        nodes[v] = v;
+    }
+    std::vector<int> localId(n, -1);
+    std::vector<std::pair<int, int> > parts(1, std::make_pair(0, n));
+    while ((int)parts.size() < regionCount) {
+        size_t largest = 0;
+        for (size_t p = 1; p < parts.size(); p++) {
+            if (parts[p].second - parts[p].first > parts[largest].second - parts[largest].first) {
+                largest = p;
+            }
+        }
+        int begin = parts[largest].first;
+        int end = parts[largest].second;
+        if (end - begin < 4) {
+            break;  // The quarters used as cut terminals would be empty
+        }
+        int middle = crpBisect(g, nodes, begin, end, localId);
+        parts[largest].second = middle;
+        parts.push_back(std::make_pair(middle, end));
+    }
+
+    std::vector<int> region(n);
+    for (size_t p = 0; p < parts.size(); p++) {
+        for (int k = parts[p].first; k < parts[p].second; k++) {
+            region[nodes[k]] = p;
+        }
+    }
+    return region;
+}
+
+/*
+    Function: buildArcFlags
+    Partitions the graph and computes the flags of every arc. Regions are handed out to a pool of
+    threads; each thread collects the bits of its regions in a private flag array, and the arrays are
+    merged at the end.
+    Parameters:
+        g: The graph.
+        regionCount: Number of regions (at most AF_MAX_REGIONS).
+        threadCount: Number of worker threads.
+    Returns:
+        The regions and flags.
+    buildArcFlags complexity: O(b (n + m) log n) for b entry nodes over all regions, divided among the threads.
+*/
+ArcFlags buildArcFlags(const Graph& g, int regionCount, int threadCount) {
+    ArcFlags result;
+    result.nodeCount = g.nodeCount;
+    result.arcCount = g.arcCount;
+    result.region = computeRegions(g, regionCount);
+    result.regionCount = 0;
+    for (int v = 0; v < g.nodeCount; v++) {
+        result.regionCount = std::max(result.regionCount, result.region[v] + 1);
+    }
+    result.flags.assign(g.arcCount, 0);
+
+    const std::vector<int>& region = result.region;
+    std::vector<std::vector<int> > entries(result.regionCount);
+    std::vector<char> isEntry(g.nodeCount, 0);
+    for (int u = 0; u < g.nodeCount; u++) {
+        for (int i = g.offsets[u]; i < g.offsets[u + 1]; i++) {
+            int v = g.arcs[i].target;
+            if (region[u] == region[v]) {
+                result.flags[i] |= 1ULL << region[u];
+            } else if (!isEntry[v]) {
+                isEntry[v] = 1;
+                entries[region[v]].push_back(v);
+            }
+        }
+    }
+
+    Graph reverse = buildReverseGraph(g);
+    std::vector<std::vector<uint64_t> > threadFlags(threadCount);
+    std::atomic<int> nextRegion(0);
+    std::atomic<int> regionsDone(0);
+    runInParallel(threadCount, [&](int threadId) {
+        std::vector<uint64_t>& flags = threadFlags[threadId];
+        flags.assign(g.arcCount, 0);
+        SearchState state;
+        initSearchState(state, g.nodeCount);
+        for (int r = nextRegion++; r < result.regionCount; r = nextRegion++) {
+            uint64_t bit = 1ULL << r;
+            for (size_t k = 0; k < entries[r].size(); k++) {
+                DAryHeapQueue<4> queue(state);
+                dijkstraWithQueue(reverse, state, queue, entries[r][k], -1);
+                for (int u = 0; u < g.nodeCount; u++) {
+                    int du = searchDistance(state, u);
+                    if (du == INF) {
+                        continue;
+                    }
+                    for (int i = g.offsets[u]; i < g.offsets[u + 1]; i++) {
+                        int dv = searchDistance(state, g.arcs[i].target);
+                        if (dv < INF && du == g.arcs[i].weight + dv) {
+                            flags[i] |= bit;
+                        }
+                    }
+                }
+            }
+            int done = ++regionsDone;
+            if (done % 8 == 0) {
+                std::cerr << "Flagged " << done << " / " << result.regionCount << " regions" << std::endl;
+            }
+        }
+        freeSearchState(state);
+    });
+    freeGraph(reverse);
+
+    for (int t = 0; t < threadCount; t++) {
+        for (int i = 0; i < g.arcCount; i++) {
+            result.flags[i] |= threadFlags[t][i];
+        }
+    }
+    return result;
+}
+
+/*
+    Function: saveArcFlags
+    Writes regions and flags to a binary file.
+    Parameters:
+        flags: The table to save.
+        path: Destination file.
+    saveArcFlags complexity: O(n + m).
+*/
+void saveArcFlags(const ArcFlags& flags, const char* path) {
+    std::ofstream out(path, std::ios::binary);
+    if (!out) {
+        throw std::runtime_error(std::string("Cannot open arc-flag file for writing: ") + path);
+    }
+    int header[4] = {AF_FILE_MAGIC, flags.nodeCount, flags.arcCount, flags.regionCount};
+    out.write((const char*)header, sizeof(header));
+    out.write((const char*)flags.region.data(), flags.region.size() * sizeof(int));
+    out.write((const char*)flags.flags.data(), flags.flags.size() * sizeof(uint64_t));
+    if (!out) {
+        throw std::runtime_error(std::string("Failed to write arc-flag file: ") + path);
+    }
+}
+
+/*
+    Function: loadArcFlags
+    Reads a table written by saveArcFlags and checks that it fits the graph.
+    Parameters:
+        g: The graph the flags must belong to.
+        path: Source file.
+    Returns:
+        The regions and flags.
+    loadArcFlags complexity: O(n + m).
+*/
+ArcFlags loadArcFlags(const Graph& g, const char* path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        throw std::runtime_error(std::string("Cannot open arc-flag file: ") + path);
+    }
+    int header[4];
+    in.read((char*)header, sizeof(header));
+    if (!in || header[0] != AF_FILE_MAGIC) {
+        throw std::runtime_error(std::string("Not an arc-flag file: ") + path);
+    }
+    if (header[1] != g.nodeCount || header[2] != g.arcCount) {
+        throw std::runtime_error("Arc-flag file does not match the graph");
+    }
+    ArcFlags flags;
+    flags.nodeCount = header[1];
+    flags.arcCount = header[2];
+    flags.regionCount = header[3];
+    flags.region.resize(flags.nodeCount);
+    flags.flags.resize(flags.arcCount);
+    in.read((char*)flags.region.data(), flags.region.size() * sizeof(int));
+    in.read((char*)flags.flags.data(), flags.flags.size() * sizeof(uint64_t));
+    if (!in) {
+        throw std::runtime_error(std::string("Truncated arc-flag file: ") + path);
+    }
+    return flags;
+}
+
+/*
+    Function: arcFlagQuery
+    Answers a point-to-point query with a Dijkstra that skips every arc whose flag for the target's
+    region is not set.
+    Parameters:
+        g: The graph the flags were computed for.
+        flags: The arc flags.
+        state: Search state receiving distances and predecessors.
+        source: The start node.
+        target: The destination node.
+        settled: Receives the number of settled nodes.
+    Returns:
+        The distance from source to target, or INF if unreachable.
+    arcFlagQuery complexity: O((n + m) log n) in the worst case, usually a narrow corridor around the path.
+*/
+int arcFlagQuery(const Graph& g, const ArcFlags& flags, SearchState& state, int source, int target,
+                 long long& settled) {
+    beginSearch(state);
+    DAryHeapQueue<4> queue(state);
+    queue.clear();
+    settled = 0;
+    touch(state, source);
+    state.dist[source] = 0;
+    queue.push(source, 0);
+
+    uint64_t bit = 1ULL << flags.region[target];
+    const uint64_t* arcFlags = flags.flags.data();
+    int* dist = state.dist;
+    while (!queue.empty()) {
+        int u = queue.pop();
+        state.heapPos[u] = SETTLED;
+        settled++;
+        if (u == target) {
+            return dist[u];
+        }
+        for (int i = g.offsets[u]; i < g.offsets[u + 1]; i++) {
+            if ((arcFlags[i] & bit) == 0) {
+                continue;
+            }
+            int v = g.arcs[i].target;
+            touch(state, v);
+            int nd = dist[u] + g.arcs[i].weight;
+            if (nd < dist[v]) {
+                dist[v] = nd;
+                state.pred[v] = u;
+                queue.push(v, nd);
+            }
+        }
+    }
+    return INF;
+}
+
+/*
+    Instrumentation
+    A run can report where its time goes: the wall time of every phase (load, search, output, ...), the
+    operation counts of its Dijkstra searches, and optionally hardware counters of the search phase read
+    through perf_event_open. The summary is written as a JSON object with --stats.
+*/
+
+#define PERF_EVENT_COUNT 4   // Hardware events sampled with --perf
+
+// Names of the hardware events, in the order of PerfCounters::values
+const char* perfEventNames[PERF_EVENT_COUNT] = {"cycles", "instructions", "cache_misses", "branch_misses"};
+
+// Hardware event counters of the calling process and the threads it starts while they are enabled
+struct PerfCounters {
+    int fds[PERF_EVENT_COUNT];              // Event descriptors, -1 for events that could not be opened
+    long long values[PERF_EVENT_COUNT];     // Counts read by stopPerfCounters, -1 if unavailable
+};
+
+// Everything reported by --stats
+struct RunStats {
+    std::vector<std::pair<std::string, double> > phases;   // Phase names and wall times in seconds, in run order
+    SearchCounters counters;                               // Dijkstra operation counts of the search phase
+    bool hasHardware;                                      // True when --perf was given
+    PerfCounters hardware;
+};
+
+/*
+    Function: recordPhase
+    Adds the time elapsed since start to a named phase, appending the phase the first time it is recorded.
+    Parameters:
+        stats: The summary to extend.
+        name: The phase name used as JSON key.
+        start: Time at which the phase began.
+    recordPhase complexity: O(1).
+*/
+void recordPhase(RunStats& stats, const char* name, std::chrono::steady_clock::time_point start) {
+    std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+    double seconds = std::chrono::duration<double>(end - start).count();
+    for (size_t i = 0; i < stats.phases.size(); i++) {
+        if (stats.phases[i].first == name) {
+            stats.phases[i].second += seconds;
+            return;
+        }
+    }
+    stats.phases.push_back(std::make_pair(std::string(name), seconds));
+}
+
+/*
+    Function: openPerfCounters
+    Opens one disabled user-space counter per hardware event. Events the kernel or the machine refuses
+    (for example under a restrictive perf_event_paranoid setting or in a virtual machine) are marked
+    unavailable instead of failing the run.
+    Parameters:
+        counters: The counters to open.
+    openPerfCounters complexity: O(1).
+*/
+void openPerfCounters(PerfCounters& counters) {
+    for (int k = 0; k < PERF_EVENT_COUNT; k++) {
+        counters.fds[k] = -1;
+        counters.values[k] = -1;
+    }
+#if defined(__linux__)
+    const unsigned long long configs[PERF_EVENT_COUNT] = {PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+                                                          PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES};
+    for (int k = 0; k < PERF_EVENT_COUNT; k++) {
+        struct perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.size = sizeof(attr);
+        attr.config = configs[k];
+        attr.disabled = 1;
+        attr.inherit = 1;          // Also count the worker threads of delta-stepping
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        counters.fds[k] = syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+    }
+#endif
+}
+
+/*
+    Function: startPerfCounters
+    Resets and enables the open counters.
+    Parameters:
+        counters: The counters to start.
+    startPerfCounters complexity: O(1).
+*/
+void startPerfCounters(PerfCounters& counters) {
+#if defined(__linux__)
+    for (int k = 0; k < PERF_EVENT_COUNT; k++) {
+        if (counters.fds[k] != -1) {
+            ioctl(counters.fds[k], PERF_EVENT_IOC_RESET, 0);
+            ioctl(counters.fds[k], PERF_EVENT_IOC_ENABLE, 0);
+        }
+    }
+#else
+    (void)counters;
+#endif
+}
+
+/*
+    Function: stopPerfCounters
+    Disables the open counters, reads their values and closes them.
+    Parameters:
+        counters: The counters to stop; values receives the counts.
+    stopPerfCounters complexity: O(1).
+*/
+void stopPerfCounters(PerfCounters& counters) {
+    for (int k = 0; k < PERF_EVENT_COUNT; k++) {
+        if (counters.fds[k] == -1) {
+            continue;
+        }
+#if defined(__linux__)
+        ioctl(counters.fds[k], PERF_EVENT_IOC_DISABLE, 0);
+        long long value;
+        if (read(counters.fds[k], &value, sizeof(value)) == (ssize_t)sizeof(value)) {
+            counters.values[k] = value;
+        }
+#endif
+        close(counters.fds[k]);
+        counters.fds[k] = -1;
+    }
+}
+
+/*
+    Function: addCounters
+    Adds the operation counts of one search state to a total; the largest queue size is the maximum of both.
+    Parameters:
+        total: The counts to extend.
+        part: The counts to add.
+    addCounters complexity: O(1).
+*/
+void addCounters(SearchCounters& total, const SearchCounters& part) {
+    total.settled += part.settled;
+    total.relaxedArcs += part.relaxedArcs;
+    total.pushes += part.pushes;
+    total.decreaseKeys += part.decreaseKeys;
+    total.pops += part.pops;
+    total.maxQueueSize = std::max(total.maxQueueSize, part.maxQueueSize);
+}
+
+/*
+    Function: writeRunStats
+    Writes the run summary as a JSON object.
+    Parameters:
+        stats: The summary to write.
+        g: The graph of the run, for its size.
+        engine: Name of the single-source engine used.
+        queueName: Name of the priority queue used by Dijkstra.
+        path: Destination file, or "-" for standard error.
+    writeRunStats complexity: O(p) for p phases.
+*/
+void writeRunStats(const RunStats& stats, const Graph& g, const char* engine, const char* queueName, const char* path) {
+    std::ostringstream json;
+    json << "{\n";
+    json << "  \"nodes\": " << g.nodeCount << ",\n";
+    json << "  \"arcs\": " << g.arcCount << ",\n";
+    json << "  \"engine\": \"" << engine << "\",\n";
+    json << "  \"queue\": \"" << queueName << "\",\n";
+    json << "  \"phases\": {";
+    double total = 0;
+    for (size_t i = 0; i < stats.phases.size(); i++) {
+        json << (i == 0 ? "\n" : ",\n") << "    \"" << stats.phases[i].first << "\": " << stats.phases[i].second;
+        total += stats.phases[i].second;
+    }
+    json << (stats.phases.empty() ? "" : ",\n") << "    \"total\": " << total << "\n  },\n";
+    json << "  \"search\": {\n";
+    json << "    \"settled\": " << stats.counters.settled << ",\n";
+    json << "    \"relaxed_arcs\": " << stats.counters.relaxedArcs << ",\n";
+    json << "    \"pushes\": " << stats.counters.pushes << ",\n";
+    json << "    \"decrease_keys\": " << stats.counters.decreaseKeys << ",\n";
+    json << "    \"pops\": " << stats.counters.pops << ",\n";
+    json << "    \"max_queue_size\": " << stats.counters.maxQueueSize << "\n  }";
+    if (stats.hasHardware) {
+        json << ",\n  \"hardware\": {";
+        for (int k = 0; k < PERF_EVENT_COUNT; k++) {
+            json << (k == 0 ? "\n" : ",\n") << "    \"" << perfEventNames[k] << "\": ";
+            if (stats.hardware.values[k] >= 0) {
+                json << stats.hardware.values[k];
+            } else {
+                json << "null";
+            }
+        }
+        json << "\n  }";
+    }
+    json << "\n}\n";
+
+    if (strcmp(path, "-") == 0) {
+        std::cerr << json.str();
+        return;
+    }
+    std::ofstream out(path);
+    out << json.str();
+    if (!out) {
+        throw std::runtime_error(std::string("Failed to write statistics file: ") + path);
+    }
+}
+
+/*
+    Result output
+    Result lines are formatted by hand into a large buffer that is written with a single write() call per
+    megabyte to every selected destination, instead of going through iostream formatting and flushing
+    each line.
+*/
+
+// Buffered writer sending the same bytes to up to two file descriptors
+struct ResultWriter {
+    int fds[2];         // Destination descriptors
+    bool ownsFd[2];     // True for descriptors opened (and closed) by the writer
+    int fdCount;
+    char* buffer;
+    size_t used;
+};
+
+/*
+    Function: formatInt
+    Writes the decimal representation of a non-negative or negative integer.
+    Parameters:
+        out: Destination with room for at least 20 characters.
+        value: The value to format.
+    Returns:
+        The number of characters written.
+    formatInt complexity: O(k) for k digits.
+*/
+int formatInt(char* out, long long value) {
+    char digits[20];
+    int count = 0;
+    unsigned long long magnitude = value < 0 ? -(unsigned long long)value : value;
+    do {
+        digits[count++] = '0' + magnitude % 10;
+        magnitude /= 10;
+    } while (magnitude > 0);
+
+    int length = 0;
+    if (value < 0) {
+        out[length++] = '-';
+    }
+    while (count > 0) {
+        out[length++] = digits[--count];
+    }
+    return length;
+}
+
+/*
+    Function: openResultWriter
+    Prepares a writer for standard output, a file, both or neither.
+    Parameters:
+        writer: The writer to open.
+        toStdout: True to write to standard output.
+        filePath: File to create and write to, or NULL.
+    openResultWriter complexity: O(1).
+*/
+void openResultWriter(ResultWriter& writer, bool toStdout, const char* filePath) {
+    writer.fdCount = 0;
+    if (toStdout) {
+        writer.fds[writer.fdCount] = STDOUT_FILENO;
+        writer.ownsFd[writer.fdCount++] = false;
+    }
+    if (filePath != NULL) {
+        int fd = open(filePath, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0) {
+            throw std::runtime_error(std::string("Cannot open output file: ") + filePath);
+        }
+        writer.fds[writer.fdCount] = fd;
+        writer.ownsFd[writer.fdCount++] = true;
+    }
+    writer.buffer = new char[OUTPUT_BUFFER_SIZE];
+    writer.used = 0;
+}
+
+/*
+    Function: flushResultWriter
+    Writes the buffered bytes to every destination of the writer.
+    Parameters:
+        writer: The writer to flush.
+    flushResultWriter complexity: O(k) for k buffered bytes.
+*/
+void flushResultWriter(ResultWriter& writer) {
+    for (int i = 0; i < writer.fdCount; i++) {
+        size_t written = 0;
+        while (written < writer.used) {
+            ssize_t n = write(writer.fds[i], writer.buffer + written, writer.used - written);
+            if (n <= 0) {
+                throw std::runtime_error("Failed to write results");
+            }
+            written += n;
+        }
+    }
+    writer.used = 0;
+}
+
+/*
+    Function: closeResultWriter
+    Flushes the writer, closes the files it opened and releases its buffer.
+    Parameters:
+        writer: The writer to close.
+    closeResultWriter complexity: O(k) for k buffered bytes.
+*/
+void closeResultWriter(ResultWriter& writer) {
+    flushResultWriter(writer);
+    for (int i = 0; i < writer.fdCount; i++) {
+        if (writer.ownsFd[i]) {
+            close(writer.fds[i]);
+        }
+    }
+    delete[] writer.buffer;
+    writer.buffer = NULL;
+    writer.fdCount = 0;
+}
+
+/*
+    Function: writeText
+    Appends raw bytes to the writer, flushing first if they do not fit.
+    Parameters:
+        writer: The writer.
+        text: The bytes to append.
+        length: Number of bytes.
+    writeText complexity: O(length).
+*/
+inline void writeText(ResultWriter& writer, const char* text, size_t length) {
+    if (writer.used + length > OUTPUT_BUFFER_SIZE) {
+        flushResultWriter(writer);
+    }
+    memcpy(writer.buffer + writer.used, text, length);
+    writer.used += length;
+}
+
+/*
+    Function: formatDistance
+    Writes a finite distance of one of the weight types; integers go through formatInt, floats are printed
+    with the 9 significant digits that identify a float exactly.
+    Parameters:
+        out: Destination with room for at least 32 characters.
+        d: The distance.
+    Returns:
+        The number of characters written.
+    formatDistance complexity: O(k) for k characters.
+*/
+inline int formatDistance(char* out, int d) {
+    return formatInt(out, d);
+}
+
+inline int formatDistance(char* out, uint32_t d) {
+    return formatInt(out, d);
+}
+
+inline int formatDistance(char* out, uint64_t d) {
+    return snprintf(out, 32, "%llu", (unsigned long long)d);
+}
+
+inline int formatDistance(char* out, float d) {
+    return snprintf(out, 32, "%.9g", d);
+}
+
+/*
+    Function: formatDistanceLine
+    Formats one "Node s to Node t : d" result line.
+    Parameters:
+        out: Destination with room for at least 80 characters.
+        source: The start node.
+        target: The destination node.
+        d: The distance, the infinity of its weight type (INF for int) if unreachable.
+    Returns:
+        The number of characters written, including the newline.
+    formatDistanceLine complexity: O(1).
+*/
+template <class W>
+int formatDistanceLine(char* out, int source, int target, W d) {
+    int length = 0;
+    memcpy(out, "Node ", 5);
+    length += 5;
+    length += formatInt(out + length, source);
+    memcpy(out + length, " to Node ", 9);
+    length += 9;
+    length += formatInt(out + length, target);
+    memcpy(out + length, " : ", 3);
+    length += 3;
+    if (d < WeightTraits<W>::infinity()) {
+        length += formatDistance(out + length, d);
+    } else {
+        memcpy(out + length, "Unreachable", 11);
+        length += 11;
+    }
+    out[length++] = '\n';
+    return length;
+}
+
+/*
+    Function: writeDistanceLine
+    Appends one "Node s to Node t : d" result line to the writer.
+    Parameters:
+        writer: The writer.
+        source: The start node.
+        target: The destination node.
+        d: The distance, the infinity of its weight type (INF for int) if unreachable.
+    writeDistanceLine complexity: O(1).
+*/
+template <class W>
+inline void writeDistanceLine(ResultWriter& writer, int source, int target, W d) {
+    if (writer.used + 80 > OUTPUT_BUFFER_SIZE) {
+        flushResultWriter(writer);
+    }
+    writer.used += formatDistanceLine(writer.buffer + writer.used, source, target, d);
+}
+
+/*
+    Function: saveBinaryDistances
+    Writes distances as raw int32 values, one per node slot 0 .. count - 1, with -1 for unreachable nodes.
+    Parameters:
+        distances: The distances, INF for unreachable nodes.
+        count: Number of node slots to write.
+        path: Destination file.
+    saveBinaryDistances complexity: O(n).
+*/
+void saveBinaryDistances(const int* distances, int count, const char* path) {
+    ResultWriter writer;
+    openResultWriter(writer, false, path);
+    for (int i = 0; i < count; i++) {
+        int32_t value = distances[i] < INF ? distances[i] : -1;
+        writeText(writer, (const char*)&value, sizeof(value));
+    }
+    closeResultWriter(writer);
+}
+
+/*
+    Function: appendDistanceLine
+    Appends one "Node s to Node t : d" result line to a response buffer.
+    Parameters:
+        out: The response buffer.
+        source: The start node.
+        target: The destination node.
+        d: The distance, INF if unreachable.
+    appendDistanceLine complexity: O(1).
+*/
+void appendDistanceLine(std::string& out, int source, int target, int d) {
+    char line[80];
+    out.append(line, formatDistanceLine(line, source, target, d));
+}
+
+/*
+    Function: appendPathLine
+    Appends one "Path from Node s to Node t : s -> ... -> t (d)" result line to a response buffer.
+    Parameters:
+        out: The response buffer.
+        source: The start node.
+        target: The destination node.
+        path: The nodes of the path, empty if unreachable.
+        d: The length of the path.
+    appendPathLine complexity: O(k) for a path of k nodes.
+*/
+void appendPathLine(std::string& out, int source, int target, const std::vector<int>& path, int d) {
+    out += "Path from Node " + std::to_string(source) + " to Node " + std::to_string(target) + " : ";
+    if (path.empty()) {
+        out += "Unreachable\n";
+        return;
+    }
+    for (size_t i = 0; i < path.size(); i++) {
+        if (i > 0) {
+            out += " -> ";
+        }
+        out += std::to_string(path[i]);
+    }
+    out += " (" + std::to_string(d) + ")\n";
+}
+
+/*
+    Function: writeAll
+    Writes a whole buffer to a file descriptor, retrying on partial writes. The socket server ignores
+    SIGPIPE, so a write to a closed connection returns an error here.
+    Parameters:
+        fd: The destination descriptor.
+        data: The bytes to write.
+    Returns:
+        False if the peer went away.
+    writeAll complexity: O(k) for k bytes.
+*/
+bool writeAll(int fd, const std::string& data) {
+    size_t written = 0;
+    while (written < data.size()) {
+        ssize_t n = write(fd, data.data() + written, data.size() - written);
+        if (n <= 0) {
+            return false;
+        }
+        written += n;
+    }
+    return true;
+}
+
+/*
+    Function: answerQuery
+    Parses one query line and appends its answer to the response buffer.
+    "s t" answers the distance from s to t with a search that stops once t is settled,
+    "s *" answers the distance from s to every node of the graph, and
+    "path s t" answers the node sequence of a shortest path from s to t, and
+    "update u v w" sets the weight of arc (u, v) to w for all later queries, and
+    "radius s r" and "nearest s k" answer the nodes within distance r of s or the k nodes closest to s,
+    in order of distance.
+    Parameters:
+        line: The query line.
+        state: Search state reused across queries.
+        backward: Second search state, used by bidirectional queries.
+        out: The response buffer.
+    answerQuery complexity: O((n + m) log n) per query in the worst case.
+*/
+void answerQuery(const std::string& line, SearchState& state, SearchState& backward, std::string& out) {
+    std::istringstream query(line);
+    size_t start = line.find_first_not_of(" \t");
+    if (line.compare(start, 6, "update") == 0) {
+        std::string keyword;
+        int from, to, weight;
+        if (!(query >> keyword >> from >> to >> weight) || weight < 0 || weight >= INF ||
+            findArc(graph, toInternal(from), toInternal(to)) == -1) {
+            out += "Invalid update: " + line + "\n";
+            return;
+        }
+        makeGraphWritable(graph);
+        setArcWeight(graph, reverseGraph, toInternal(from), toInternal(to), weight);
+        dialBucketCount = std::max(dialBucketCount, weight + 1);
+        out += "Arc " + std::to_string(from) + " to " + std::to_string(to) + " : " + std::to_string(weight) + "\n";
+        return;
+    }
+    bool wantRadius = line.compare(start, 6, "radius") == 0;
+    if (wantRadius || line.compare(start, 7, "nearest") == 0) {
+        std::string keyword;
+        int source, bound;
+        if (!(query >> keyword >> source >> bound) || source < 0 || source >= graph.nodeCount || bound < (wantRadius ? 0 : 1)) {
+            out += "Invalid query: " + line + "\n";
+            return;
+        }
+        std::vector<int> settled = boundedSearch(graph, state, toInternal(source), wantRadius ? bound : INF,
+                                                 wantRadius ? 0 : bound, std::vector<int>());
+        for (size_t k = 0; k < settled.size(); k++) {
+            appendDistanceLine(out, source, toOriginal(settled[k]), state.dist[settled[k]]);
+        }
+        return;
+    }
+    bool wantPath = line.compare(start, 4, "path") == 0;
+    if (wantPath) {
+        std::string keyword;
+        query >> keyword;
+    }
+    int source;
+    std::string targetToken;
+    if (!(query >> source >> targetToken) || source < 0 || source >= graph.nodeCount) {
+        out += "Invalid query: " + line + "\n";
+        return;
+    }
+
+    if (targetToken == "*" && !wantPath) {
+        dijkstra(graph, state, toInternal(source), -1);
+        for (int i = 1; i < graph.nodeCount; i++) {
+            appendDistanceLine(out, source, i, searchDistance(state, toInternal(i)));
+        }
+        return;
+    }
+
+    char* end = NULL;
+    long target = strtol(targetToken.c_str(), &end, 10);
+    if (*end != '\0' || target < 0 || target >= graph.nodeCount) {
+        out += "Invalid query: " + line + "\n";
+        return;
+    }
+    if (wantPath) {
+        std::vector<int> path;
+        int d = pointToPoint(state, backward, source, target, &path);
+        appendPathLine(out, source, target, path, d);
+    } else {
+        appendDistanceLine(out, source, target, pointToPoint(state, backward, source, target, NULL));
+    }
+}
+
+/*
+    Function: serveConnection
+    Reads newline separated queries from a descriptor until end of input and writes each answer
+    back as soon as its line has been processed.
+    Parameters:
+        inFd: Descriptor the queries are read from.
+        outFd: Descriptor the answers are written to.
+        state: Search state reused across queries.
+        backward: Second search state, used by bidirectional queries.
+    serveConnection complexity: O(q * (n + m) log n) for q queries in the worst case.
+*/
+void serveConnection(int inFd, int outFd, SearchState& state, SearchState& backward) {
+    std::string pending;
+    std::string response;
+    char buffer[4096];
+    ssize_t n;
+    bool open = true;
+    while (open && (n = read(inFd, buffer, sizeof(buffer))) > 0) {
+        pending.append(buffer, n);
+        size_t lineStart = 0;
+        size_t newline;
+        while ((newline = pending.find('\n', lineStart)) != std::string::npos) {
+            std::string line = pending.substr(lineStart, newline - lineStart);
+            lineStart = newline + 1;
+            if (line.find_first_not_of(" \t\r") == std::string::npos) {
+                continue;  // Skip empty lines
+            }
+            response.clear();
+            answerQuery(line, state, backward, response);
+            if (!writeAll(outFd, response)) {
+                open = false;
+                break;
+            }
+        }
+        pending.erase(0, lineStart);
+    }
+    if (open && pending.find_first_not_of(" \t\r") != std::string::npos) {
+        response.clear();
+        answerQuery(pending, state, backward, response);  // Last line without a trailing newline
+        writeAll(outFd, response);
+    }
+}
+
+/*
+    Function: runServer
+    Keeps the loaded graph in memory and answers queries until the input ends. Queries come from
+    standard input, or from clients connecting one after another to a local Unix socket.
+    Parameters:
+        socketPath: Path of the Unix socket to listen on, or NULL to serve standard input.
+    runServer complexity: O(q * (n + m) log n) for q queries in the worst case.
+*/
+void runServer(const char* socketPath) {
+    SearchState state, backward;
+    initSearchState(state, graph.nodeCount);
+    initSearchState(backward, graph.nodeCount);
+
+    if (socketPath == NULL) {
+        serveConnection(STDIN_FILENO, STDOUT_FILENO, state, backward);
+        freeSearchState(state);
+        freeSearchState(backward);
+        return;
+    }
+
+    int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    struct sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (listener < 0 || strlen(socketPath) >= sizeof(address.sun_path)) {
+        freeSearchState(state);
+        freeSearchState(backward);
+        throw std::runtime_error(std::string("Cannot create socket: ") + socketPath);
+    }
+    strcpy(address.sun_path, socketPath);
+    unlink(socketPath);
+    if (bind(listener, (struct sockaddr*)&address, sizeof(address)) < 0 || listen(listener, 16) < 0) {
+        close(listener);
+        freeSearchState(state);
+        freeSearchState(backward);
+        throw std::runtime_error(std::string("Cannot listen on socket: ") + socketPath);
+    }
+    std::cerr << "Listening on " << socketPath << std::endl;
+
+    // A client that disconnects before reading its reply must only end its own connection: with SIGPIPE
+    // ignored, write() fails with EPIPE and writeAll reports it instead of the signal killing the server
+    signal(SIGPIPE, SIG_IGN);
+    while (true) {
+        int client = accept(listener, NULL, NULL);
+        if (client >= 0) {
+            serveConnection(client, client, state, backward);
+            close(client);
+        }
+    }
+}
+
+/*
+    Function: runChQueries
+    Loads a saved contraction hierarchy and answers "s t" queries read from standard input,
+    one per line, printing the distance of each pair and the average query time on stderr.
+    Parameters:
+        indexPath: The hierarchy file written by --ch-build.
+    runChQueries complexity: O(q * k log k) for q queries with upward search spaces of size k.
+*/
+void runChQueries(const char* indexPath) {
+    ChIndex index = loadContractionHierarchy(indexPath);
+    ChQueryState state;
+    initChQueryState(state, index.nodeCount);
+
+    long long queryCount = 0;
+    long long settledTotal = 0;
+    double queryMicros = 0;
+    int source, target;
+    while (std::cin >> source >> target) {
+        if (source < 0 || source >= index.nodeCount || target < 0 || target >= index.nodeCount) {
+            std::cout << "Node " << source << " to Node " << target << " : Invalid node" << "\n";
+            continue;
+        }
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        int d = chQuery(index, state, source, target);
+        std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+        queryMicros += std::chrono::duration<double, std::micro>(end - start).count();
+        settledTotal += state.settled;
+        queryCount++;
+
+        if (d < INF) {
+            std::cout << "Node " << source << " to Node " << target << " : " << d << "\n";
+        } else {
+            std::cout << "Node " << source << " to Node " << target << " : Unreachable" << "\n";
+        }
+    }
+    if (queryCount > 0) {
+        std::cerr << "Answered " << queryCount << " queries, average " << queryMicros / queryCount
+                  << " us and " << settledTotal / queryCount << " settled nodes per query" << std::endl;
+    }
+}
+
+/*
+    Function: runHlQueries
+    Loads saved hub labels and answers "s t" queries read from standard input, one per line, printing the
+    distance of each pair and the average query time on stderr.
+    Parameters:
+        labelPath: The label file written by --hl-build.
+    runHlQueries complexity: O(q * L) for q queries with labels of size L.
+*/
+void runHlQueries(const char* labelPath) {
+    HubLabels labels = loadHubLabels(labelPath);
+
+    long long queryCount = 0;
+    double queryMicros = 0;
+    std::string out;
+    int source, target;
+    while (std::cin >> source >> target) {
+        if (source < 0 || source >= labels.nodeCount || target < 0 || target >= labels.nodeCount) {
+            std::cout << "Node " << source << " to Node " << target << " : Invalid node" << "\n";
+            continue;
+        }
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        int d = hlQuery(labels, source, target);
+        std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+        queryMicros += std::chrono::duration<double, std::micro>(end - start).count();
+        queryCount++;
+
+        out.clear();
+        appendDistanceLine(out, source, target, d);
+        std::cout << out;
+    }
+    if (queryCount > 0) {
+        std::cerr << "Answered " << queryCount << " queries, average " << queryMicros / queryCount
+                  << " us per query" << std::endl;
+    }
+}
+
+/*
+    Function: loadCustomizedOverlay
+    Loads a partition for the global graph, builds its boundaries and customizes every cell.
+    Parameters:
+        partitionPath: The partition file written by --crp-build.
+        threadCount: Number of customization threads.
+    Returns:
+        The customized overlay.
+    loadCustomizedOverlay complexity: See customizeCrp.
+*/
+CrpOverlay loadCustomizedOverlay(const char* partitionPath, int threadCount) {
+    CrpOverlay overlay = loadCrpPartition(partitionPath);
+    buildCrpTopology(graph, overlay);
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    long long cells = customizeCrp(graph, overlay, threadCount, NULL);
+    std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+    std::cerr << "Customized " << cells << " cells on " << threadCount << " threads in "
+              << std::chrono::duration<double>(end - start).count() << " s" << std::endl;
+    return overlay;
+}
+
+/*
+    Function: runCrpQueries
+    Customizes a partition for the current weights, optionally applies weight updates and customizes
+    the affected cells again, then answers "s t" queries read from standard input, printing the
+    distance of each pair and the average query time on stderr.
+    Parameters:
+        partitionPath: The partition file written by --crp-build.
+        updatesPath: File of "u v w" weight updates applied before the queries, or NULL.
+        threadCount: Number of customization threads.
+    runCrpQueries complexity: Customization plus O(q * k log k) for q queries searching k nodes.
+*/
+void runCrpQueries(const char* partitionPath, const char* updatesPath, int threadCount) {
+    CrpOverlay overlay = loadCustomizedOverlay(partitionPath, threadCount);
+
+    if (updatesPath != NULL) {
+        std::vector<ArcUpdate> updates = readArcUpdates(updatesPath);
+        makeGraphWritable(graph);
+        std::vector<std::vector<char> > dirty(overlay.levels.size());
+        for (size_t l = 0; l < overlay.levels.size(); l++) {
+            dirty[l].assign(overlay.levels[l].cellCount, 0);
+        }
+        for (size_t k = 0; k < updates.size(); k++) {
+            int from = updates[k].from;
+            int to = updates[k].to;
+            setArcWeight(graph, reverseGraph, from, to, updates[k].weight);
+            // Arcs between cells are searched directly; only cells containing both ends use the arc in a clique
+            for (size_t l = 0; l < overlay.levels.size(); l++) {
+                if (overlay.levels[l].cell[from] == overlay.levels[l].cell[to]) {
+                    dirty[l][overlay.levels[l].cell[from]] = 1;
+                }
+            }
+        }
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        long long cells = customizeCrp(graph, overlay, threadCount, &dirty);
+        std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+        std::cerr << "Applied " << updates.size() << " updates and customized " << cells << " cells again in "
+                  << std::chrono::duration<double>(end - start).count() << " s" << std::endl;
+    }
+
+    ChQueryState state;
+    initChQueryState(state, graph.nodeCount);
+    long long queryCount = 0;
+    double queryMicros = 0;
+    std::string out;
+    int source, target;
+    while (std::cin >> source >> target) {
+        if (source < 0 || source >= graph.nodeCount || target < 0 || target >= graph.nodeCount) {
+            std::cout << "Node " << source << " to Node " << target << " : Invalid node" << "\n";
+            continue;
+        }
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        int d = crpQuery(graph, reverseGraph, overlay, state, source, target);
+        std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+        queryMicros += std::chrono::duration<double, std::micro>(end - start).count();
+        queryCount++;
+
+        out.clear();
+        appendDistanceLine(out, source, target, d);
+        std::cout << out;
+    }
+    if (queryCount > 0) {
+        std::cerr << "Answered " << queryCount << " queries, average " << queryMicros / queryCount
+                  << " us per query" << std::endl;
+    }
+}
+
+/*
+    Function: runAltQueries
+    Loads landmark tables and answers "s t" queries read from standard input with A*, printing the
+    distance of each pair and the average query time and settled nodes on stderr.
+    Parameters:
+        g: The graph the tables were built for.
+        indexPath: The landmark file written by --alt-build.
+    runAltQueries complexity: O(q * (n + m) log n) in the worst case for q queries.
+*/
+void runAltQueries(const Graph& g, const char* indexPath) {
+    AltIndex index = loadAltIndex(indexPath);
+    if (index.nodeCount != g.nodeCount) {
+        throw std::runtime_error("Landmark file does not match the graph");
+    }
+    SearchState state;
+    initSearchState(state, g.nodeCount);
+
+    long long queryCount = 0;
+    long long settledTotal = 0;
+    double queryMicros = 0;
+    std::string out;
+    int source, target;
+    while (std::cin >> source >> target) {
+        if (source < 0 || source >= g.nodeCount || target < 0 || target >= g.nodeCount) {
+            std::cout << "Node " << source << " to Node " << target << " : Invalid node" << "\n";
+            continue;
+        }
+        long long settled = 0;
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        int d = altQuery(g, index, state, source, target, settled);
+        std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+        queryMicros += std::chrono::duration<double, std::micro>(end - start).count();
+        settledTotal += settled;
+        queryCount++;
+
+        out.clear();
+        appendDistanceLine(out, source, target, d);
+        std::cout << out;
+    }
+    if (queryCount > 0) {
+        std::cerr << "Answered " << queryCount << " queries, average " << queryMicros / queryCount
+                  << " us and " << settledTotal / queryCount << " settled nodes per query" << std::endl;
+    }
+    freeSearchState(state);
+}
+
+/*
+    Function: runArcFlagQueries
+    Loads arc flags and answers "s t" queries read from standard input with the pruned Dijkstra, printing
+    the distance of each pair and the average query time and settled nodes on stderr.
+    Parameters:
+        g: The graph the flags were computed for.
+        flagPath: The arc-flag file written by --af-build.
+    runArcFlagQueries complexity: O(q * (n + m) log n) in the worst case for q queries.
+*/
+void runArcFlagQueries(const Graph& g, const char* flagPath) {
+    ArcFlags flags = loadArcFlags(g, flagPath);
+    SearchState state;
+    initSearchState(state, g.nodeCount);
+
+    long long queryCount = 0;
+    long long settledTotal = 0;
+    double queryMicros = 0;
+    std::string out;
+    int source, target;
+    while (std::cin >> source >> target) {
+        if (source < 0 || source >= g.nodeCount || target < 0 || target >= g.nodeCount) {
+            std::cout << "Node " << source << " to Node " << target << " : Invalid node" << "\n";
+            continue;
+        }
+        long long settled = 0;
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        int d = arcFlagQuery(g, flags, state, source, target, settled);
+        std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+        queryMicros += std::chrono::duration<double, std::micro>(end - start).count();
+        settledTotal += settled;
+        queryCount++;
+
+        out.clear();
+        appendDistanceLine(out, source, target, d);
+        std::cout << out;
+    }
+    if (queryCount > 0) {
+        std::cerr << "Answered " << queryCount << " queries, average " << queryMicros / queryCount
+                  << " us and " << settledTotal / queryCount << " settled nodes per query" << std::endl;
+    }
+    freeSearchState(state);
+}
+
+/*
+    Function: runTypedSingleSource
+    Loads a DIMACS text graph with weights of type W (binary CSR files are rejected) and prints the distances from the start node in the
+    format of the default run. The search is the dijkstraWithQueue instance of W with the binary or d-ary
+    heap selected by queueKind.
+    Parameters:
+        graphPath: The graph file, or NULL to read standard input.
+        startNode: The start node.
+        toStdout: True to print the lines on standard output.
+        filePath: File receiving the lines as well, or NULL.
+    runTypedSingleSource complexity: O((n + m) log n).
+*/
+template <class W>
+void runTypedSingleSource(const char* graphPath, int startNode, bool toStdout, const char* filePath) {
+    std::ifstream inFile(graphPath != NULL ? graphPath : "/dev/stdin");
+    if (!inFile) {
+        throw std::runtime_error(std::string("Cannot open graph file: ") + graphPath);
+    }
+    if (graphPath != NULL) {
+        // Binary CSR files hold int weights in the mmap layout, which the text parser would read as nothing
+        uint32_t magic = 0;
+        inFile.read((char*)&magic, sizeof(magic));
+        if (inFile && magic == GRAPH_FILE_MAGIC) {
+            throw std::runtime_error(std::string("--weights needs a DIMACS text graph, not a binary CSR file: ") + graphPath);
+        }
+        inFile.clear();
+        inFile.seekg(0);
+    }
+    BasicGraph<W> g = loadGraph<W>(inFile);
+    if (startNode >= g.nodeCount) {
+        throw std::runtime_error("Start node " + std::to_string(startNode) + " is not in the graph");
+    }
+
+    BasicSearchState<W> state;
+    initSearchState(state, g.nodeCount);
+    if (queueKind == QUEUE_DARY2) {
+        DAryHeapQueue<2, W> queue(state);
+        dijkstraWithQueue(g, state, queue, startNode, -1);
+    } else if (queueKind == QUEUE_DARY4) {
+        DAryHeapQueue<4, W> queue(state);
+        dijkstraWithQueue(g, state, queue, startNode, -1);
+    } else if (queueKind == QUEUE_DARY8) {
+        DAryHeapQueue<8, W> queue(state);
+        dijkstraWithQueue(g, state, queue, startNode, -1);
+    } else {
+        BasicBinaryHeapQueue<W> queue(state);
+        dijkstraWithQueue(g, state, queue, startNode, -1);
+    }
+
+    if (toStdout || filePath != NULL) {
+        ResultWriter writer;
+        openResultWriter(writer, toStdout, filePath);
+        for (int i = 1; i < g.nodeCount; i++) {
+            writeDistanceLine(writer, startNode, i, searchDistance(state, i));
+        }
+        closeResultWriter(writer);
+    }
+    freeSearchState(state);
+    freeGraph(g);
+}
+
+/*
+    Function: readNodeList
+    Reads whitespace separated node ids from a file.
+    Parameters:
+        path: The file to read.
+        nodeCount: Number of node slots; every id must lie below it.
+    Returns:
+        The node ids in file order.
+    readNodeList complexity: O(k) for k ids.
+*/
+std::vector<int> readNodeList(const char* path, int nodeCount) {
+    std::ifstream in(path);
+    if (!in) {
+        throw std::runtime_error(std::string("Cannot open node list: ") + path);
+    }
+    std::vector<int> nodes;
+    int node;
+    while (in >> node) {
+        if (node < 0 || node >= nodeCount) {
+            throw std::runtime_error("Node id out of range in " + std::string(path) + ": " + std::to_string(node));
+        }
+        nodes.push_back(node);
+    }
+    return nodes;
+}
+
+/*
+    Function: writeDistanceRow
+    Runs a full Dijkstra from a source and writes its distance row to "<outDir>/source_<s>.txt".
+    Parameters:
+        state: The search state of the calling thread.
+        source: The start node.
+        outDir: Directory receiving the row file.
+    writeDistanceRow complexity: O((n + m) log n).
+*/
+void writeDistanceRow(SearchState& state, int source, const std::string& outDir) {
+    dijkstra(graph, state, toInternal(source), -1);
+    std::string path = outDir + "/source_" + std::to_string(source) + ".txt";
+    ResultWriter writer;
+    openResultWriter(writer, false, path.c_str());
+    for (int i = 1; i < graph.nodeCount; i++) {
+        writeDistanceLine(writer, source, i, searchDistance(state, toInternal(i)));
+    }
+    closeResultWriter(writer);
+}
+
+/*
+    Function: runMultiSource
+    Computes the distance rows of many sources in parallel. Worker threads share the read-only graph,
+    each owns a SearchState, and they take the next unprocessed source from an atomic counter, so the
+    load stays balanced even if some searches take longer than others.
+    Parameters:
+        sources: The start nodes.
+        threadCount: Number of worker threads.
+        outDir: Directory receiving one row file per source.
+    runMultiSource complexity: O(k (n + m) log n / p) for k sources on p threads.
+*/
+void runMultiSource(const std::vector<int>& sources, int threadCount, const std::string& outDir) {
+    std::atomic<size_t> next(0);
+    std::atomic<bool> failed(false);
+    std::string failure;
+    std::mutex failureLock;
+
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threadCount; t++) {
+        workers.push_back(std::thread([&]() {
+            SearchState state;
+            initSearchState(state, graph.nodeCount);
+            size_t i;
+            while (!failed && (i = next++) < sources.size()) {
+                try {
+                    writeDistanceRow(state, sources[i], outDir);
+                } catch (const std::exception& e) {
+                    std::lock_guard<std::mutex> guard(failureLock);
+                    failure = e.what();
+                    failed = true;
+                }
+            }
+            freeSearchState(state);
+        }));
+    }
+    for (size_t t = 0; t < workers.size(); t++) {
+        workers[t].join();
+    }
+    if (failed) {
+        throw std::runtime_error(failure);
+    }
+}
+
+/*
+    Function: runBoundedSearch
+    Runs a bounded single-source search and writes its result lines: one line per target, in the order
+    of the target list, when targets are given (targets not settled within the limits are unreachable),
+    and otherwise one line per settled node in order of distance.
+    Parameters:
+        source: The start node.
+        radius: Largest distance to settle, INF for no bound.
+        nearestCount: Number of nodes to settle, 0 for no limit.
+        targets: Nodes whose settling ends the search, empty for none.
+        toStdout: Write the lines to standard output.
+        filePath: Also write them to this file, or NULL.
+    runBoundedSearch complexity: See boundedSearch.
+*/
+void runBoundedSearch(int source, int radius, int nearestCount, const std::vector<int>& targets,
+                      bool toStdout, const char* filePath) {
+    SearchState state;
+    initSearchState(state, graph.nodeCount);
+    std::vector<int> internalTargets(targets.size());
+    for (size_t k = 0; k < targets.size(); k++) {
+        internalTargets[k] = toInternal(targets[k]);
+    }
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::vector<int> settled = boundedSearch(graph, state, toInternal(source), radius, nearestCount, internalTargets);
+    std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+    std::cerr << "Settled " << settled.size() << " nodes in "
+              << std::chrono::duration<double, std::milli>(end - start).count() << " ms" << std::endl;
+
+    if (toStdout || filePath != NULL) {
+        ResultWriter writer;
+        openResultWriter(writer, toStdout, filePath);
+        if (!targets.empty()) {
+            for (size_t k = 0; k < targets.size(); k++) {
+                int u = internalTargets[k];
+                bool isSettled = searchDistance(state, u) < INF && state.heapPos[u] == SETTLED;
+                writeDistanceLine(writer, source, targets[k], isSettled ? state.dist[u] : INF);
+            }
+        } else {
+            for (size_t k = 0; k < settled.size(); k++) {
+                writeDistanceLine(writer, source, toOriginal(settled[k]), state.dist[settled[k]]);
+            }
+        }
+        closeResultWriter(writer);
+    }
+    freeSearchState(state);
+}
+
+/*
+    Many-to-many distance tables
+    Bucket-based table computation on a contraction hierarchy. Every shortest path is an upward part from the
+    source followed by a downward part to the target, meeting at their highest node. A backward upward search
+    from every target leaves an entry (target, distance) in the bucket of every node it settles; a forward
+    upward search from every source then scans the buckets of the nodes it settles and combines the distances.
+    Each search touches only a few hundred nodes, so the table costs |S| + |T| small searches plus the bucket
+    scans instead of one full Dijkstra per source. Both phases run on a pool of threads with one query state
+    per thread.
+*/
+
+// Bucket entry left by the backward search of one target
+struct BucketEntry {
+    int column;    // Index of the target in the target list
+    int dist;      // Upward distance from the bucket's node to the target
+};
+
+/*
+    Function: chUpwardSearch
+    Runs an upward search to exhaustion and lists the settled nodes. Stalled nodes (reachable on a shorter
+    path through a higher ranked node) are neither expanded nor listed, as no shortest path meets there.
+    Parameters:
+        offsets, arcs: Upward arcs followed by the search.
+        stallOffsets, stallArcs: Upward arcs of the opposite direction, used for stalling.
+        root: The start node.
+        state: Query scratch space; its forward arrays are used.
+        space: Receives the (node, distance) pairs of the search space.
+    chUpwardSearch complexity: O(k log k) for a search space of k nodes.
+*/
+void chUpwardSearch(const std::vector<int>& offsets, const std::vector<ChArc>& arcs,
+                    const std::vector<int>& stallOffsets, const std::vector<ChArc>& stallArcs,
+                    int root, ChQueryState& state, std::vector<std::pair<int, int> >& space) {
+    std::vector<int>& dist = state.distF;
+    std::vector<int>& stamp = state.stampF;
+    std::vector<std::pair<int, int> >& heap = state.heapF;
+    int round = ++state.round;
+    space.clear();
+    heap.clear();
+    dist[root] = 0;
+    stamp[root] = round;
+    heap.push_back(std::make_pair(0, root));
+    while (!heap.empty()) {
+        std::pop_heap(heap.begin(), heap.end(), std::greater<std::pair<int, int> >());
+        int d = heap.back().first;
+        int u = heap.back().second;
+        heap.pop_back();
+        if (d > dist[u]) {
+            continue;  // Stale heap entry
+        }
+        bool stalled = false;
+        for (int i = stallOffsets[u]; i < stallOffsets[u + 1] && !stalled; i++) {
+            int x = stallArcs[i].node;
+            stalled = stamp[x] == round && dist[x] + stallArcs[i].weight < d;
+        }
+        if (stalled) {
+            continue;
+        }
+        space.push_back(std::make_pair(u, d));
+        for (int i = offsets[u]; i < offsets[u + 1]; i++) {
+            int v = arcs[i].node;
+            int nd = d + arcs[i].weight;
+            if (stamp[v] != round || nd < dist[v]) {
+                stamp[v] = round;
+                dist[v] = nd;
+                heap.push_back(std::make_pair(nd, v));
+                std::push_heap(heap.begin(), heap.end(), std::greater<std::pair<int, int> >());
+            }
+        }
+    }
+}
+
+/*
+    Function: computeChTable
+    Computes the distances from every source to every target with buckets on a contraction hierarchy.
+    Parameters:
+        index: The contraction hierarchy.
+        sources: The row nodes.
+        targets: The column nodes.
+        threadCount: Number of worker threads.
+    Returns:
+        The |sources| x |targets| table in row-major order, INF for unreachable pairs.
+    computeChTable complexity: O((|S| + |T|) k log k + |S| b / p) for search spaces of k nodes, b bucket entries
+    scanned per source and p threads.
+*/
+std::vector<int> computeChTable(const ChIndex& index, const std::vector<int>& sources, const std::vector<int>& targets,
+                                int threadCount) {
+    int columns = targets.size();
+    std::vector<ChQueryState> states(threadCount);
+    for (int t = 0; t < threadCount; t++) {
+        initChQueryState(states[t], index.nodeCount);
+    }
+
+    // Backward phase: every thread collects (node, column, distance) triples of the targets it takes
+    std::vector<std::vector<std::pair<int, BucketEntry> > > collected(threadCount);
+    std::atomic<int> nextTarget(0);
+    runInParallel(threadCount, [&](int t) {
+        std::vector<std::pair<int, int> > space;
+        int j;
+        while ((j = nextTarget.fetch_add(1)) < columns) {
+            chUpwardSearch(index.bwdOffsets, index.bwdArcs, index.fwdOffsets, index.fwdArcs, targets[j], states[t], space);
+            for (size_t k = 0; k < space.size(); k++) {
+                BucketEntry entry = {j, space[k].second};
+                collected[t].push_back(std::make_pair(space[k].first, entry));
+            }
+        }
+    });
+
+    // Group the entries by node into one contiguous array (counting sort)
+    std::vector<int> bucketOffsets(index.nodeCount + 1, 0);
+    for (int t = 0; t < threadCount; t++) {
+        for (size_t k = 0; k < collected[t].size(); k++) {
+            bucketOffsets[collected[t][k].first + 1]++;
+        }
+    }
+    for (int v = 0; v < index.nodeCount; v++) {
+        bucketOffsets[v + 1] += bucketOffsets[v];
+    }
+    std::vector<BucketEntry> buckets(bucketOffsets[index.nodeCount]);
+    std::vector<int> cursor(bucketOffsets.begin(), bucketOffsets.end() - 1);
+    for (int t = 0; t < threadCount; t++) {
+        for (size_t k = 0; k < collected[t].size(); k++) {
+            buckets[cursor[collected[t][k].first]++] = collected[t][k].second;
+        }
+        std::vector<std::pair<int, BucketEntry> >().swap(collected[t]);
+    }
+
+    // Forward phase: every source fills its own row from the buckets of its search space
+    std::vector<int> table((size_t)sources.size() * columns, INF);
+    std::atomic<int> nextSource(0);
+    runInParallel(threadCount, [&](int t) {
+        std::vector<std::pair<int, int> > space;
+        int i;
+        while ((i = nextSource.fetch_add(1)) < (int)sources.size()) {
+            chUpwardSearch(index.fwdOffsets, index.fwdArcs, index.bwdOffsets, index.bwdArcs, sources[i], states[t], space);
+            int* row = &table[(size_t)i * columns];
+            for (size_t k = 0; k < space.size(); k++) {
+                int x = space[k].first;
+                int d = space[k].second;
+                for (int b = bucketOffsets[x]; b < bucketOffsets[x + 1]; b++) {
+                    if (d + buckets[b].dist < row[buckets[b].column]) {
+                        row[buckets[b].column] = d + buckets[b].dist;
+                    }
+                }
+            }
+        }
+    });
+    return table;
+}
+
+/*
+    Function: saveDistanceMatrix
+    Writes a distance table as int32 values: the row count, the column count, then the rows one after
+    another, with -1 for unreachable pairs.
+    Parameters:
+        table: The table in row-major order, INF for unreachable pairs.
+        rows: Number of rows.
+        columns: Number of columns.
+        path: Destination file.
+    saveDistanceMatrix complexity: O(rows * columns).
+*/
+void saveDistanceMatrix(const std::vector<int>& table, int rows, int columns, const char* path) {
+    ResultWriter writer;
+    openResultWriter(writer, false, path);
+    int32_t header[2] = {rows, columns};
+    writeText(writer, (const char*)header, sizeof(header));
+    for (size_t k = 0; k < table.size(); k++) {
+        int32_t value = table[k] < INF ? table[k] : -1;
+        writeText(writer, (const char*)&value, sizeof(value));
+    }
+    closeResultWriter(writer);
+}
+
+/*
+    Function: computeDijkstraTable
+    Computes a distance table without a hierarchy: one Dijkstra per source, run in parallel and stopped
+    as soon as all targets are settled.
+    Parameters:
+        sources: The row nodes.
+        targets: The column nodes.
+        threadCount: Number of worker threads.
+    Returns:
+        The |sources| x |targets| table in row-major order, INF for unreachable pairs.
+    computeDijkstraTable complexity: O(|S| (n + m) log n / p) in the worst case, less when the targets are close.
+*/
+std::vector<int> computeDijkstraTable(const std::vector<int>& sources, const std::vector<int>& targets, int threadCount) {
+    int columns = targets.size();
+    std::vector<int> internalTargets(columns);
+    for (int j = 0; j < columns; j++) {
+        internalTargets[j] = toInternal(targets[j]);
+    }
+    std::vector<int> table((size_t)sources.size() * columns, INF);
+    std::atomic<int> nextSource(0);
+    runInParallel(threadCount, [&](int) {
+        SearchState state;
+        initSearchState(state, graph.nodeCount);
+        int i;
+        while ((i = nextSource.fetch_add(1)) < (int)sources.size()) {
+            // Once the search stops, every target is settled or unreachable
+            boundedSearch(graph, state, toInternal(sources[i]), INF, 0, internalTargets);
+            for (int j = 0; j < columns; j++) {
+                table[(size_t)i * columns + j] = searchDistance(state, internalTargets[j]);
+            }
+        }
+        freeSearchState(state);
+    });
+    return table;
+}
+
+/*
+    Function: runChTable
+    Loads a saved contraction hierarchy, computes the distance table between two node lists and saves it.
+    Parameters:
+        indexPath: The hierarchy file written by --ch-build.
+        sourcesPath: File listing the row nodes.
+        targetsPath: File listing the column nodes.
+        matrixPath: Destination of the binary table.
+        threadCount: Number of worker threads.
+    runChTable complexity: See computeChTable.
+*/
+void runChTable(const char* indexPath, const char* sourcesPath, const char* targetsPath, const char* matrixPath,
+                int threadCount) {
+    ChIndex index = loadContractionHierarchy(indexPath);
+    std::vector<int> sources = readNodeList(sourcesPath, index.nodeCount);
+    std::vector<int> targets = readNodeList(targetsPath, index.nodeCount);
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::vector<int> table = computeChTable(index, sources, targets, threadCount);
+    std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+    saveDistanceMatrix(table, sources.size(), targets.size(), matrixPath);
+    std::cerr << "Computed a " << sources.size() << " x " << targets.size() << " table on " << threadCount
+              << " threads in " << std::chrono::duration<double>(end - start).count() << " s and saved it to "
+              << matrixPath << std::endl;
+}
+
+/*
+    Benchmark
+    --bench measures the point-to-point engines on reproducible query sets drawn from the loaded graph, in
+    the style of the DIMACS shortest path challenge: uniformly random s-t pairs, and Dijkstra-rank pairs
+    whose target is the 2^r-th node settled by a Dijkstra search from the source, so that every distance
+    scale from local to graph-wide is measured separately. Every engine answers every query, each answer is
+    checked against the binary heap Dijkstra, and throughput and latency percentiles are reported.
+*/
+
+#define BENCH_MIN_RANK_LOG 4   // Smallest Dijkstra rank measured is 2^4
+
+// A named list of s-t queries (original node ids) with their reference distances
+struct BenchSet {
+    std::string name;
+    std::vector<std::pair<int, int> > queries;
+    std::vector<int> reference;    // Distances from the binary heap Dijkstra, filled by the first engine
+};
+
+// A point-to-point engine under test: answers d(s, t) for original node ids
+struct BenchEngine {
+    std::string name;
+    std::function<int(int, int)> query;
+};
+
+/*
+    Function: makeBenchSets
+    Draws the random and Dijkstra-rank query sets. The same seed always yields the same sets on the
+    same graph.
+    Parameters:
+        queryCount: Number of random pairs; a tenth of it (at least one) sources are used per rank.
+        seed: Seed of the random generator.
+    Returns:
+        The random set followed by one set per rank 2^r, from 2^4 up to the number of reachable nodes.
+    makeBenchSets complexity: O(q + (q / 10) * (n + m) log n) for q random queries.
+*/
+std::vector<BenchSet> makeBenchSets(int queryCount, unsigned seed) {
+    std::mt19937 generator(seed);
+    std::uniform_int_distribution<int> pick(0, graph.nodeCount - 1);
+    std::vector<BenchSet> sets(1);
+    sets[0].name = "random";
+    for (int k = 0; k < queryCount; k++) {
+        int source = pick(generator);
+        sets[0].queries.push_back(std::make_pair(source, pick(generator)));
+    }
+
+    int maxRankLog = BENCH_MIN_RANK_LOG;
+    while ((2LL << maxRankLog) < graph.nodeCount) {
+        maxRankLog++;
+    }
+    for (int r = BENCH_MIN_RANK_LOG; r <= maxRankLog; r++) {
+        BenchSet set;
+        set.name = "rank 2^" + std::to_string(r);
+        sets.push_back(set);
+    }
+
+    SearchState state;
+    initSearchState(state, graph.nodeCount);
+    int sourceCount = std::max(1, queryCount / 10);
+    for (int k = 0; k < sourceCount; k++) {
+        int source = pick(generator);
+        std::vector<int> settled;
+        SearchLimits limits = {INF, (1 << maxRankLog) + 1, NULL, 0, &settled};
+        dijkstra(graph, state, toInternal(source), -1, &limits);
+        for (int r = BENCH_MIN_RANK_LOG; r <= maxRankLog; r++) {
+            if ((1 << r) < (int)settled.size()) {
+                sets[r - BENCH_MIN_RANK_LOG + 1].queries.push_back(std::make_pair(source, toOriginal(settled[1 << r])));
+            }
+        }
+    }
+    freeSearchState(state);
+
+    // Drop ranks larger than any source could reach
+    while (sets.size() > 1 && sets.back().queries.empty()) {
+        sets.pop_back();
+    }
+    return sets;
+}
+
+/*
+    Function: latencyPercentile
+    Reads a percentile from sorted latencies by the nearest-rank method.
+    Parameters:
+        sorted: Latencies in increasing order, not empty.
+        percent: The percentile, between 0 and 100.
+    Returns:
+        The latency at that percentile.
+    latencyPercentile complexity: O(1).
+*/
+double latencyPercentile(const std::vector<double>& sorted, double percent) {
+    size_t rank = (size_t)std::ceil(percent / 100 * sorted.size());
+    return sorted[std::max((size_t)1, rank) - 1];
+}
+
+/*
+    Function: runBenchmark
+    Runs every available engine over the random and Dijkstra-rank query sets and prints one line per
+    engine and set with the query rate, latency percentiles and the number of answers that differ from
+    the binary heap Dijkstra, which always runs first and provides the reference distances.
+    Parameters:
+        queryCount: Number of random queries (see makeBenchSets).
+        seed: Seed of the query sets.
+        chPath: Contraction hierarchy of the graph to include, or NULL.
+        altPath: Landmark tables of the graph to include, or NULL.
+        hlPath: Hub labels of the graph to include, or NULL.
+        crpPath: Partition of the graph to customize and include, or NULL.
+        afPath: Arc flags of the graph to include, or NULL.
+        threadCount: Number of threads customizing the partition.
+    Returns:
+        The total number of wrong answers.
+    runBenchmark complexity: O(e * q * (n + m) log n) for e engines and q queries in the worst case.
+*/
+long long runBenchmark(int queryCount, unsigned seed, const char* chPath, const char* altPath, const char* hlPath,
+                       const char* crpPath, const char* afPath, int threadCount) {
+    std::vector<BenchSet> sets = makeBenchSets(queryCount, seed);
+
+    SearchState forward, backward;
+    initSearchState(forward, graph.nodeCount);
+    initSearchState(backward, graph.nodeCount);
+    std::vector<BenchEngine> engines;
+    const char* queueNames[] = {"binary", "radix", "dial", "dary2", "dary4", "dary8"};
+    const QueueKind queueKinds[] = {QUEUE_BINARY, QUEUE_RADIX, QUEUE_DIAL, QUEUE_DARY2, QUEUE_DARY4, QUEUE_DARY8};
+    for (int k = 0; k < 6; k++) {
+        QueueKind kind = queueKinds[k];
+        BenchEngine engine = {std::string("dijkstra-") + queueNames[k], [&forward, kind](int s, int t) {
+            queueKind = kind;
+            return dijkstra(graph, forward, toInternal(s), toInternal(t));
+        }};
+        engines.push_back(engine);
+    }
+    BenchEngine bidirectional = {"bidirectional", [&forward, &backward](int s, int t) {
+        int meeting;
+        return bidirectionalDijkstra(graph, reverseGraph, forward, backward, toInternal(s), toInternal(t), meeting);
+    }};
+    engines.push_back(bidirectional);
+
+    ChIndex chIndex;
+    ChQueryState chState;
+    if (chPath != NULL) {
+        chIndex = loadContractionHierarchy(chPath);
+        if (chIndex.nodeCount != graph.nodeCount) {
+            throw std::runtime_error("Hierarchy file does not match the graph");
+        }
+        initChQueryState(chState, chIndex.nodeCount);
+        BenchEngine engine = {"ch", [&chIndex, &chState](int s, int t) { return chQuery(chIndex, chState, s, t); }};
+        engines.push_back(engine);
+    }
+    AltIndex altIndex;
+    if (altPath != NULL) {
+        altIndex = loadAltIndex(altPath);
+        if (altIndex.nodeCount != graph.nodeCount) {
+            throw std::runtime_error("Landmark file does not match the graph");
+        }
+        BenchEngine engine = {"alt", [&altIndex, &forward](int s, int t) {
+            long long settled;
+            return altQuery(graph, altIndex, forward, s, t, settled);
+        }};
+        engines.push_back(engine);
+    }
+    HubLabels labels;
+    if (hlPath != NULL) {
+        labels = loadHubLabels(hlPath);
+        if (labels.nodeCount != graph.nodeCount) {
+            throw std::runtime_error("Label file does not match the graph");
+        }
+        BenchEngine engine = {"hl", [&labels](int s, int t) { return hlQuery(labels, s, t); }};
+        engines.push_back(engine);
+    }
+    CrpOverlay overlay;
+    ChQueryState crpState;
+    if (crpPath != NULL) {
+        overlay = loadCustomizedOverlay(crpPath, threadCount);
+        initChQueryState(crpState, graph.nodeCount);
+        BenchEngine engine = {"crp", [&overlay, &crpState](int s, int t) {
+            return crpQuery(graph, reverseGraph, overlay, crpState, s, t);
+        }};
+        engines.push_back(engine);
+    }
+    ArcFlags arcFlags;
+    if (afPath != NULL) {
+        arcFlags = loadArcFlags(graph, afPath);
+        BenchEngine engine = {"arc-flags", [&arcFlags, &forward](int s, int t) {
+            long long settled;
+            return arcFlagQuery(graph, arcFlags, forward, s, t, settled);
+        }};
+        engines.push_back(engine);
+    }
+
+    char line[256];
+    snprintf(line, sizeof(line), "%-18s %-12s %8s %12s %10s %10s %10s %10s %7s\n",
+             "engine", "set", "queries", "queries/s", "p50 us", "p90 us", "p99 us", "max us", "errors");
+    std::cout << line;
+    QueueKind selectedQueue = queueKind;
+    long long errorTotal = 0;
+    for (size_t e = 0; e < engines.size(); e++) {
+        for (size_t k = 0; k < sets.size(); k++) {
+            BenchSet& set = sets[k];
+            std::vector<double> latencies;
+            long long errors = 0;
+            double totalSeconds = 0;
+            for (size_t q = 0; q < set.queries.size(); q++) {
+                std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+                int d = engines[e].query(set.queries[q].first, set.queries[q].second);
+                std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+                double seconds = std::chrono::duration<double>(end - start).count();
+                totalSeconds += seconds;
+                latencies.push_back(seconds * 1e6);
+                if (e == 0) {
+                    set.reference.push_back(d);
+                } else if (d != set.reference[q]) {
+                    errors++;
+                }
+            }
+            if (latencies.empty()) {
+                continue;
+            }
+            std::sort(latencies.begin(), latencies.end());
+            snprintf(line, sizeof(line), "%-18s %-12s %8zu %12.1f %10.1f %10.1f %10.1f %10.1f %7lld\n",
+                     engines[e].name.c_str(), set.name.c_str(), set.queries.size(),
+                     totalSeconds > 0 ? set.queries.size() / totalSeconds : 0.0,
+                     latencyPercentile(latencies, 50), latencyPercentile(latencies, 90),
+                     latencyPercentile(latencies, 99), latencies.back(), errors);
+            std::cout << line << std::flush;
+            errorTotal += errors;
+        }
+    }
+    queueKind = selectedQueue;
+
+    freeSearchState(forward);
+    freeSearchState(backward);
+    return errorTotal;
+}
+
+/*
+    Function: printUsage
+    Prints the command line options of the program.
+*/
+void printUsage(const char* program) {
+    std::cerr << "Usage:\n"
+              << "  " << program << " < graph                  Dijkstra from node 7 to every node\n"
+              << "  " << program << " --ch-build FILE < graph  Build a contraction hierarchy and save it to FILE\n"
+              << "  " << program << " --ch-query FILE < pairs  Answer \"s t\" queries using the hierarchy in FILE\n"
+              << "  " << program << " --ch-table FILE --sources S --targets T --matrix-out M [--threads N]\n"
+              << "                                    Distance table from the nodes in S to the nodes in T using the\n"
+              << "                                    hierarchy in FILE, saved as int32 rows, columns and values\n"
+              << "  " << program << " --hl-build FILE [--hl-order ch|degree] < graph\n"
+              << "                                    Build hub labels (hubs in contraction order by default) and save them\n"
+              << "  " << program << " --hl-query FILE < pairs  Answer \"s t\" distance queries using the hub labels in FILE\n"
+              << "  " << program << " --crp-build FILE < graph Partition the graph into nested cells for customizable route planning\n"
+              << "  " << program << " --crp-query FILE --graph G [--updates U] [--threads N] < pairs\n"
+              << "                                    Customize the partition in FILE for the weights of G (and again\n"
+              << "                                    after the updates in U), then answer \"s t\" distance queries\n"
+              << "  " << program << " --alt-build FILE [--landmarks K] [--avoid] < graph\n"
+              << "                                    Select K landmarks (default 16) and save their distance tables\n"
+              << "  " << program << " --alt-query FILE --graph G < pairs\n"
+              << "                                    Answer \"s t\" queries with A* using the landmarks in FILE\n"
+              << "  " << program << " --af-build FILE [--regions K] [--threads N] < graph\n"
+              << "                                    Split the graph into K regions (default 64, at most 64) and save\n"
+              << "                                    the arc flags of every region\n"
+              << "  " << program << " --af-query FILE --graph G < pairs\n"
+              << "                                    Answer \"s t\" queries with Dijkstra pruned by the arc flags in FILE\n"
+              << "  " << program << " --convert FILE < graph   Save the graph as a binary CSR file\n"
+              << "  " << program << " --serve --graph FILE     Answer \"s t\", \"s *\", \"path s t\" and \"update u v w\" lines from stdin\n"
+              << "  " << program << " --bench --graph FILE [--queries N] [--seed S] [--bench-ch F] [--bench-alt F] [--bench-hl F] [--bench-crp F]\n"
+              << "          [--bench-af F]\n"
+              << "                                    Time every point-to-point engine on N random and Dijkstra-rank\n"
+              << "                                    queries (default 100), checked against the binary heap Dijkstra\n"
+              << "  " << program << " --sources FILE --out-dir DIR [--threads N] < graph\n"
+              << "                                    Distance rows of every source in FILE, one file per source\n"
+              << "Options:\n"
+              << "  --source S       Start node of the single-source run (default 7)\n"
+              << "  --sssp ENGINE    Single-source engine: heap (default) or delta\n"
+              << "  --delta D        Bucket width of delta-stepping (default: average arc weight)\n"
+              << "  --queue KIND     Priority queue of Dijkstra: binary (default), radix, dial,\n"
+              << "                   dary2, dary4 or dary8\n"
+              << "  --output DEST    Where the single-source run prints its lines: both (default, stdout and\n"
+              << "                   output.txt), stdout, file or none\n"
+              << "  --binary-out FILE  Also save the single-source distances as int32 values (-1 if unreachable)\n"
+              << "  --bidir          Answer point-to-point queries (--serve, --path) with bidirectional Dijkstra\n"
+              << "  --radius R       Only settle the nodes within distance R of the start node and print them\n"
+              << "  --nearest K      Only settle the K nodes closest to the start node and print them\n"
+              << "  --targets FILE   Stop once the nodes in FILE are settled and print their distances; with\n"
+              << "                   --sources and --matrix-out M, save the table of all pairs to M\n"
+              << "  --path T         Print the shortest path from the start node to T instead of all distances\n"
+              << "  --tree-out FILE  Also save the shortest path tree of the single-source run (binary int32)\n"
+              << "  --reorder ORDER  Renumber the nodes for memory locality before searching: bfs, rcm or partition\n"
+              << "  --updates FILE   Apply the \"u v w\" arc weight updates in FILE after the single-source run,\n"
+              << "                   repairing its shortest path tree incrementally\n"
+              << "  --repair-limit F Fraction of the nodes a repair may settle before a full recomputation (default 0.1)\n"
+              << "  --validate       Check the distances against the binary heap Dijkstra\n"
+              << "  --stats FILE     Write phase times and Dijkstra operation counts of the single-source run as JSON\n"
+              << "                   to FILE (- for stderr)\n"
+              << "  --perf           With --stats, also read hardware counters of the search phase (perf_event_open)\n"
+              << "  --weights TYPE   Weight and distance type of the single-source run: int (default), uint32,\n"
+              << "                   uint64 or float; the others read a DIMACS text graph and use the binary or\n"
+              << "                   d-ary heaps\n"
+              << "  --graph FILE     Read the graph from FILE (binary CSR files are memory mapped, text files are parsed\n"
+              << "                   by --threads threads) instead of stdin\n"
+              << "  --verify         Check the checksum of a binary graph file before using it\n"
+              << "  --socket PATH    With --serve, read queries from clients of a Unix socket instead of stdin\n";
+}
+
+/*
+    Complexity of main: O((n + m) log n), where n is the number of nodes and m is the number of edges.
+    Building the CSR graph takes O(n + m). For Dijkstra's algorithm, the min-heap operations (insertion,
+    extraction) and edge relaxation are performed for each edge, leading to a complexity of O((n + m) log n).
+    This ensures an efficient computation of the shortest paths in sparse graphs.
+    The --ch-build and --ch-query modes replace the single-source run by contraction hierarchy
+    preprocessing and point-to-point queries respectively, and --serve answers a stream of queries
+    on the loaded graph. --sources computes the rows of many sources on a pool of threads.
+*/
+int main(int argc, char* argv[]) {
+    try {
+        const char* chBuildPath = NULL;
+        const char* chQueryPath = NULL;
+        const char* chTablePath = NULL;
+        const char* targetsPath = NULL;
+        const char* matrixPath = NULL;
+        const char* convertPath = NULL;
+        const char* altBuildPath = NULL;
+        const char* hlBuildPath = NULL;
+        const char* hlQueryPath = NULL;
+        HubOrder hubOrder = HUB_ORDER_CH;
+        const char* altQueryPath = NULL;
+        int landmarkCount = 16;
+        bool useAvoid = false;
+        const char* graphPath = NULL;
+        const char* socketPath = NULL;
+        bool verifyGraph = false;
+        const char* sourcesPath = NULL;
+        const char* outDir = NULL;
+        int threadCount = std::max(1u, std::thread::hardware_concurrency());
+        int startNode = 7;  // Starting node for Dijkstra's algorithm
+        const char* engine = "heap";
+        int delta = 0;
+        bool validate = false;
+        bool serve = false;
+        int pathTarget = -1;
+        bool outputToStdout = true;
+        bool outputToFile = true;
+        const char* binaryOutPath = NULL;
+        const char* treePath = NULL;
+        const char* updatesPath = NULL;
+        double repairLimit = 0.1;
+        int radius = INF;
+        int nearestCount = 0;
+        NodeOrder nodeOrder = ORDER_NONE;
+        const char* statsPath = NULL;
+        bool bench = false;
+        int benchQueryCount = 100;
+        unsigned benchSeed = 1;
+        const char* benchChPath = NULL;
+        const char* benchAltPath = NULL;
+        const char* benchHlPath = NULL;
+        const char* benchCrpPath = NULL;
+        const char* crpBuildPath = NULL;
+        const char* crpQueryPath = NULL;
+        const char* afBuildPath = NULL;
+        const char* afQueryPath = NULL;
+        const char* benchAfPath = NULL;
+        int regionCount = 64;
+        const char* weightType = "int";
+        const char* queueName = "binary";
+        RunStats stats;
+        memset(&stats.counters, 0, sizeof(stats.counters));
+        stats.hasHardware = false;
+        for (int i = 1; i < argc; i++) {
+            if (strcmp(argv[i], "--ch-build") == 0 && i + 1 < argc) {
+                chBuildPath = argv[++i];
+            } else if (strcmp(argv[i], "--ch-query") == 0 && i + 1 < argc) {
+                chQueryPath = argv[++i];
+            } else if (strcmp(argv[i], "--ch-table") == 0 && i + 1 < argc) {
+                chTablePath = argv[++i];
+            } else if (strcmp(argv[i], "--targets") == 0 && i + 1 < argc) {
+                targetsPath = argv[++i];
+            } else if (strcmp(argv[i], "--matrix-out") == 0 && i + 1 < argc) {
+                matrixPath = argv[++i];
+            } else if (strcmp(argv[i], "--hl-build") == 0 && i + 1 < argc) {
+                hlBuildPath = argv[++i];
+            } else if (strcmp(argv[i], "--hl-query") == 0 && i + 1 < argc) {
+                hlQueryPath = argv[++i];
+            } else if (strcmp(argv[i], "--hl-order") == 0 && i + 1 < argc) {
+                i++;
+                if (strcmp(argv[i], "ch") == 0) {
+                    hubOrder = HUB_ORDER_CH;
+                } else if (strcmp(argv[i], "degree") == 0) {
+                    hubOrder = HUB_ORDER_DEGREE;
+                } else {
+                    throw std::runtime_error(std::string("Unknown hub order: ") + argv[i]);
+                }
+            } else if (strcmp(argv[i], "--alt-build") == 0 && i + 1 < argc) {
+                altBuildPath = argv[++i];
+            } else if (strcmp(argv[i], "--alt-query") == 0 && i + 1 < argc) {
+                altQueryPath = argv[++i];
+            } else if (strcmp(argv[i], "--landmarks") == 0 && i + 1 < argc) {
+                landmarkCount = std::max(1, atoi(argv[++i]));
+            } else if (strcmp(argv[i], "--avoid") == 0) {
+                useAvoid = true;
+            } else if (strcmp(argv[i], "--convert") == 0 && i + 1 < argc) {
+                convertPath = argv[++i];
+            } else if (strcmp(argv[i], "--graph") == 0 && i + 1 < argc) {
+                graphPath = argv[++i];
+            } else if (strcmp(argv[i], "--verify") == 0) {
+                verifyGraph = true;
+            } else if (strcmp(argv[i], "--serve") == 0) {
+                serve = true;
+            } else if (strcmp(argv[i], "--socket") == 0 && i + 1 < argc) {
+                socketPath = argv[++i];
+            } else if (strcmp(argv[i], "--sources") == 0 && i + 1 < argc) {
+                sourcesPath = argv[++i];
+            } else if (strcmp(argv[i], "--out-dir") == 0 && i + 1 < argc) {
+                outDir = argv[++i];
+            } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+                threadCount = std::max(1, atoi(argv[++i]));
+            } else if (strcmp(argv[i], "--source") == 0 && i + 1 < argc) {
+                startNode = atoi(argv[++i]);
+            } else if (strcmp(argv[i], "--sssp") == 0 && i + 1 < argc) {
+                engine = argv[++i];
+            } else if (strcmp(argv[i], "--delta") == 0 && i + 1 < argc) {
+                delta = atoi(argv[++i]);
+            } else if (strcmp(argv[i], "--queue") == 0 && i + 1 < argc) {
+                i++;
+                queueName = argv[i];
+                if (strcmp(argv[i], "binary") == 0) {
+                    queueKind = QUEUE_BINARY;
+                } else if (strcmp(argv[i], "radix") == 0) {
+                    queueKind = QUEUE_RADIX;
+                } else if (strcmp(argv[i], "dial") == 0) {
+                    queueKind = QUEUE_DIAL;
+                } else if (strcmp(argv[i], "dary2") == 0) {
+                    queueKind = QUEUE_DARY2;
+                } else if (strcmp(argv[i], "dary4") == 0) {
+                    queueKind = QUEUE_DARY4;
+                } else if (strcmp(argv[i], "dary8") == 0) {
+                    queueKind = QUEUE_DARY8;
+                } else {
+                    throw std::runtime_error(std::string("Unknown priority queue: ") + argv[i]);
+                }
+            } else if (strcmp(argv[i], "--output") == 0 && i + 1 < argc) {
+                i++;
+                outputToStdout = strcmp(argv[i], "stdout") == 0 || strcmp(argv[i], "both") == 0;
+                outputToFile = strcmp(argv[i], "file") == 0 || strcmp(argv[i], "both") == 0;
+                if (!outputToStdout && !outputToFile && strcmp(argv[i], "none") != 0) {
+                    throw std::runtime_error(std::string("Unknown output destination: ") + argv[i]);
+                }
+            } else if (strcmp(argv[i], "--binary-out") == 0 && i + 1 < argc) {
+                binaryOutPath = argv[++i];
+            } else if (strcmp(argv[i], "--bidir") == 0) {
+                bidirectionalQueries = true;
+            } else if (strcmp(argv[i], "--path") == 0 && i + 1 < argc) {
+                pathTarget = atoi(argv[++i]);
+            } else if (strcmp(argv[i], "--tree-out") == 0 && i + 1 < argc) {
+                treePath = argv[++i];
+            } else if (strcmp(argv[i], "--reorder") == 0 && i + 1 < argc) {
+                i++;
+                if (strcmp(argv[i], "bfs") == 0) {
+                    nodeOrder = ORDER_BFS;
+                } else if (strcmp(argv[i], "rcm") == 0) {
+                    nodeOrder = ORDER_RCM;
+                } else if (strcmp(argv[i], "partition") == 0) {
+                    nodeOrder = ORDER_PARTITION;
+                } else {
+                    throw std::runtime_error(std::string("Unknown node order: ") + argv[i]);
+                }
+            } else if (strcmp(argv[i], "--radius") == 0 && i + 1 < argc) {
+                radius = std::max(0, atoi(argv[++i]));
+            } else if (strcmp(argv[i], "--nearest") == 0 && i + 1 < argc) {
+                nearestCount = std::max(1, atoi(argv[++i]));
+            } else if (strcmp(argv[i], "--updates") == 0 && i + 1 < argc) {
+                updatesPath = argv[++i];
+            } else if (strcmp(argv[i], "--repair-limit") == 0 && i + 1 < argc) {
+                repairLimit = atof(argv[++i]);
+            } else if (strcmp(argv[i], "--validate") == 0) {
+                validate = true;
+            } else if (strcmp(argv[i], "--bench") == 0) {
+                bench = true;
+            } else if (strcmp(argv[i], "--queries") == 0 && i + 1 < argc) {
+                benchQueryCount = std::max(1, atoi(argv[++i]));
+            } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+                benchSeed = strtoul(argv[++i], NULL, 10);
+            } else if (strcmp(argv[i], "--bench-ch") == 0 && i + 1 < argc) {
+                benchChPath = argv[++i];
+            } else if (strcmp(argv[i], "--bench-alt") == 0 && i + 1 < argc) {
+                benchAltPath = argv[++i];
+            } else if (strcmp(argv[i], "--bench-hl") == 0 && i + 1 < argc) {
+                benchHlPath = argv[++i];
+            } else if (strcmp(argv[i], "--bench-crp") == 0 && i + 1 < argc) {
+                benchCrpPath = argv[++i];
+            } else if (strcmp(argv[i], "--bench-af") == 0 && i + 1 < argc) {
+                benchAfPath = argv[++i];
+            } else if (strcmp(argv[i], "--af-build") == 0 && i + 1 < argc) {
+                afBuildPath = argv[++i];
+            } else if (strcmp(argv[i], "--af-query") == 0 && i + 1 < argc) {
+                afQueryPath = argv[++i];
+            } else if (strcmp(argv[i], "--regions") == 0 && i + 1 < argc) {
+                regionCount = std::min(AF_MAX_REGIONS, std::max(1, atoi(argv[++i])));
+            } else if (strcmp(argv[i], "--weights") == 0 && i + 1 < argc) {
+                weightType = argv[++i];
+                if (strcmp(weightType, "int") != 0 && strcmp(weightType, "uint32") != 0 &&
+                    strcmp(weightType, "uint64") != 0 && strcmp(weightType, "float") != 0) {
+                    throw std::runtime_error(std::string("Unknown weight type: ") + weightType);
+                }
+            } else if (strcmp(argv[i], "--crp-build") == 0 && i + 1 < argc) {
+                crpBuildPath = argv[++i];
+            } else if (strcmp(argv[i], "--crp-query") == 0 && i + 1 < argc) {
+                crpQueryPath = argv[++i];
+            } else if (strcmp(argv[i], "--stats") == 0 && i + 1 < argc) {
+                statsPath = argv[++i];
+            } else if (strcmp(argv[i], "--perf") == 0) {
+                stats.hasHardware = true;
+            } else {
+                printUsage(argv[0]);
+                return 1;
+            }
+        }
+
+        if (chQueryPath != NULL) {
+            runChQueries(chQueryPath);
+            return 0;
+        }
+        if (hlQueryPath != NULL) {
+            runHlQueries(hlQueryPath);
+            return 0;
+        }
+        if (chTablePath != NULL) {
+            if (sourcesPath == NULL || targetsPath == NULL || matrixPath == NULL) {
+                throw std::runtime_error("--ch-table needs --sources, --targets and --matrix-out");
+            }
+            runChTable(chTablePath, sourcesPath, targetsPath, matrixPath, threadCount);
+            return 0;
+        }
+
+        if (strcmp(engine, "heap") != 0 && strcmp(engine, "delta") != 0) {
+            throw std::runtime_error(std::string("Unknown single-source engine: ") + engine);
+        }
+        if ((pathTarget != -1 || treePath != NULL || updatesPath != NULL) && strcmp(engine, "heap") != 0) {
+            throw std::runtime_error("--path, --tree-out and --updates need the predecessors of --sssp heap");
+        }
+
+        if (serve && graphPath == NULL && socketPath == NULL) {
+            throw std::runtime_error("--serve reads queries from stdin, so the graph must be given with --graph");
+        }
+        if (crpQueryPath != NULL && graphPath == NULL) {
+            throw std::runtime_error("--crp-query reads queries from stdin, so the graph must be given with --graph");
+        }
+        if (altQueryPath != NULL && graphPath == NULL) {
+            throw std::runtime_error("--alt-query reads queries from stdin, so the graph must be given with --graph");
+        }
+        if (afQueryPath != NULL && graphPath == NULL) {
+            throw std::runtime_error("--af-query reads queries from stdin, so the graph must be given with --graph");
+        }
+        if (nodeOrder != ORDER_NONE && (convertPath != NULL || altBuildPath != NULL || altQueryPath != NULL ||
+                                        chBuildPath != NULL || hlBuildPath != NULL || benchAltPath != NULL ||
+                                        crpBuildPath != NULL || crpQueryPath != NULL || benchCrpPath != NULL ||
+                                        afBuildPath != NULL || afQueryPath != NULL || benchAfPath != NULL)) {
+            throw std::runtime_error("--reorder only applies to searches on the loaded graph, not to saved files or indexes");
+        }
+
+        if (strcmp(weightType, "int") != 0) {
+            bool otherMode = chBuildPath != NULL || chQueryPath != NULL || chTablePath != NULL || hlBuildPath != NULL ||
+                             hlQueryPath != NULL || altBuildPath != NULL || altQueryPath != NULL ||
+                             crpBuildPath != NULL || crpQueryPath != NULL || afBuildPath != NULL ||
+                             afQueryPath != NULL || convertPath != NULL || sourcesPath != NULL || serve || bench;
+            bool otherOption = strcmp(engine, "heap") != 0 || pathTarget != -1 || treePath != NULL ||
+                               updatesPath != NULL || targetsPath != NULL || binaryOutPath != NULL ||
+                               statsPath != NULL || radius != INF || nearestCount > 0 || validate ||
+                               nodeOrder != ORDER_NONE;
+            if (otherMode || otherOption) {
+                throw std::runtime_error("--weights only applies to the plain single-source run (--source, --queue, --output, --graph)");
+            }
+            if (queueKind == QUEUE_RADIX || queueKind == QUEUE_DIAL) {
+                throw std::runtime_error("--queue radix and dial need --weights int");
+            }
+            const char* filePath = outputToFile ? "output.txt" : NULL;
+            if (strcmp(weightType, "uint32") == 0) {
+                runTypedSingleSource<uint32_t>(graphPath, startNode, outputToStdout, filePath);
+            } else if (strcmp(weightType, "uint64") == 0) {
+                runTypedSingleSource<uint64_t>(graphPath, startNode, outputToStdout, filePath);
+            } else {
+                runTypedSingleSource<float>(graphPath, startNode, outputToStdout, filePath);
+            }
+            return 0;
+        }
+
+        std::chrono::steady_clock::time_point loadStart = std::chrono::steady_clock::now();
+        if (graphPath != NULL) {
+            graph = loadGraphFile(graphPath, verifyGraph, threadCount);
+        } else {
+            std::ifstream inFile("/dev/stdin");  // Input file containing the graph data
+            graph = loadGraph(inFile);
+        }
+        recordPhase(stats, "load", loadStart);
+
+        if (nodeOrder != ORDER_NONE) {
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            reorderGraph(nodeOrder);
+            recordPhase(stats, "reorder", start);
+            std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+            std::cerr << "Reordered " << graph.nodeCount << " nodes in "
+                      << std::chrono::duration<double>(end - start).count() << " s" << std::endl;
+        }
+
+        dialBucketCount = maxArcWeight(graph) + 1;
+        if (bidirectionalQueries || updatesPath != NULL || bench || crpQueryPath != NULL) {
+            std::chrono::steady_clock::time_point reverseStart = std::chrono::steady_clock::now();
+            reverseGraph = buildReverseGraph(graph);
+            recordPhase(stats, "reverse", reverseStart);
+        }
+
+        if (convertPath != NULL) {
+            saveGraphBinary(graph, convertPath);
+            std::cerr << "Saved " << graph.nodeCount << " nodes and " << graph.arcCount
+                      << " arcs to " << convertPath << std::endl;
+            freeGraph(graph);
+            return 0;
+        }
+
+        if (altBuildPath != NULL) {
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            AltIndex index = buildAltIndex(graph, landmarkCount, useAvoid);
+            std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+            saveAltIndex(index, altBuildPath);
+            std::cerr << index.landmarkCount << " landmarks selected in "
+                      << std::chrono::duration<double>(end - start).count() << " s and saved to " << altBuildPath << ":";
+            for (int i = 0; i < index.landmarkCount; i++) {
+                std::cerr << " " << index.landmarks[i];
+            }
+            std::cerr << std::endl;
+            freeGraph(graph);
+            return 0;
+        }
+
+        if (altQueryPath != NULL) {
+            runAltQueries(graph, altQueryPath);
+            freeGraph(graph);
+            return 0;
+        }
+
+        if (afBuildPath != NULL) {
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            ArcFlags flags = buildArcFlags(graph, regionCount, threadCount);
+            std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+            saveArcFlags(flags, afBuildPath);
+            long long flagBits = 0;
+            for (int i = 0; i < graph.arcCount; i++) {
+                flagBits += __builtin_popcountll(flags.flags[i]);
+            }
+            std::cerr << "Arc flags for " << flags.regionCount << " regions (" << (double)flagBits / std::max(1, graph.arcCount)
+                      << " set per arc) built in " << std::chrono::duration<double>(end - start).count()
+                      << " s and saved to " << afBuildPath << std::endl;
+            freeGraph(graph);
+            return 0;
+        }
+
+        if (afQueryPath != NULL) {
+            runArcFlagQueries(graph, afQueryPath);
+            freeGraph(graph);
+            return 0;
+        }
+
+        if (chBuildPath != NULL) {
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            ChIndex index = buildContractionHierarchy(graph);
+            std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+            saveContractionHierarchy(index, chBuildPath);
+            std::cerr << "Contraction hierarchy with " << index.fwdArcs.size() + index.bwdArcs.size()
+                      << " upward arcs built in " << std::chrono::duration<double>(end - start).count()
+                      << " s and saved to " << chBuildPath << std::endl;
+            freeGraph(graph);
+            return 0;
+        }
+
+        if (crpBuildPath != NULL) {
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            CrpOverlay overlay = computeCrpPartition(graph);
+            std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+            saveCrpPartition(overlay, crpBuildPath);
+            buildCrpTopology(graph, overlay);
+            for (size_t l = 0; l < overlay.levels.size(); l++) {
+                std::cerr << "Level " << l << ": " << overlay.levels[l].cellCount << " cells, "
+                          << overlay.levels[l].boundary.size() << " boundary nodes, "
+                          << overlay.levels[l].clique.size() << " clique entries" << std::endl;
+            }
+            std::cerr << "Partition with " << overlay.levels.size() << " levels computed in "
+                      << std::chrono::duration<double>(end - start).count() << " s and saved to " << crpBuildPath << std::endl;
+            freeGraph(graph);
+            return 0;
+        }
+
+        if (crpQueryPath != NULL) {
+            runCrpQueries(crpQueryPath, updatesPath, threadCount);
+            freeGraph(reverseGraph);
+            freeGraph(graph);
+            return 0;
+        }
+
+        if (hlBuildPath != NULL) {
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            HubLabels labels = buildHubLabels(graph, hubOrder);
+            std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+            saveHubLabels(labels, hlBuildPath);
+            std::cerr << "Hub labels with " << (double)(labels.fwdHubs.size() + labels.bwdHubs.size()) / labels.nodeCount
+                      << " entries per node built in " << std::chrono::duration<double>(end - start).count()
+                      << " s and saved to " << hlBuildPath << std::endl;
+            freeGraph(graph);
+            return 0;
+        }
+
+        if (bench) {
+            long long errors = runBenchmark(benchQueryCount, benchSeed, benchChPath, benchAltPath, benchHlPath,
+                                             benchCrpPath, benchAfPath, threadCount);
+            freeGraph(reverseGraph);
+            freeGraph(graph);
+            if (errors > 0) {
+                throw std::runtime_error(std::to_string(errors) + " benchmark answers differ from the binary heap Dijkstra");
+            }
+            return 0;
+        }
+
+        if (serve) {
+            runServer(socketPath);
+            freeGraph(reverseGraph);
+            freeGraph(graph);
+            return 0;
+        }
+
+        if (matrixPath != NULL) {
+            if (sourcesPath == NULL || targetsPath == NULL) {
+                throw std::runtime_error("--matrix-out needs --sources and --targets");
+            }
+            std::vector<int> sources = readNodeList(sourcesPath, graph.nodeCount);
+            std::vector<int> targets = readNodeList(targetsPath, graph.nodeCount);
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            std::vector<int> table = computeDijkstraTable(sources, targets, threadCount);
+            std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+            saveDistanceMatrix(table, sources.size(), targets.size(), matrixPath);
+            std::cerr << "Computed a " << sources.size() << " x " << targets.size() << " table on " << threadCount
+                      << " threads in " << std::chrono::duration<double>(end - start).count() << " s" << std::endl;
+            freeGraph(graph);
+            return 0;
+        }
+
+        if (startNode < 0 || startNode >= graph.nodeCount) {
+            throw std::runtime_error("Start node out of range: " + std::to_string(startNode));
+        }
+        if (pathTarget != -1 && (pathTarget < 0 || pathTarget >= graph.nodeCount)) {
+            throw std::runtime_error("Path target out of range: " + std::to_string(pathTarget));
+        }
+
+        if (radius < INF || nearestCount > 0 || targetsPath != NULL) {
+            std::vector<int> targets;
+            if (targetsPath != NULL) {
+                targets = readNodeList(targetsPath, graph.nodeCount);
+            }
+            runBoundedSearch(startNode, radius, nearestCount, targets, outputToStdout, outputToFile ? "output.txt" : NULL);
+            freeGraph(graph);
+            return 0;
+        }
+
+        if (sourcesPath != NULL) {
+            std::vector<int> sources = readNodeList(sourcesPath, graph.nodeCount);
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            runMultiSource(sources, threadCount, outDir != NULL ? outDir : ".");
+            std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+            std::cerr << "Computed " << sources.size() << " distance rows on " << threadCount << " threads in "
+                      << std::chrono::duration<double>(end - start).count() << " s" << std::endl;
+            freeGraph(graph);
+            return 0;
+        }
+
+        if (pathTarget != -1) {
+            SearchState state, backward;
+            initSearchState(state, graph.nodeCount);
+            initSearchState(backward, graph.nodeCount);
+            std::vector<int> path;
+            int d = pointToPoint(state, backward, startNode, pathTarget, &path);
+            std::string line;
+            appendPathLine(line, startNode, pathTarget, path, d);
+            std::cout << line;
+            freeSearchState(state);
+            freeSearchState(backward);
+            freeGraph(reverseGraph);
+            freeGraph(graph);
+            return 0;
+        }
+
+        // Dijkstra's algorithm: process nodes to find shortest paths
+        SearchState state;
+        initSearchState(state, graph.nodeCount);
+        std::vector<int> distances(graph.nodeCount, INF);
+        if (stats.hasHardware) {
+            openPerfCounters(stats.hardware);
+            startPerfCounters(stats.hardware);
+        }
+        std::chrono::steady_clock::time_point searchStart = std::chrono::steady_clock::now();
+        if (strcmp(engine, "delta") == 0) {
+            std::vector<int> result = deltaStepping(graph, toInternal(startNode), delta > 0 ? delta : defaultDelta(graph), threadCount);
+            for (int i = 0; i < graph.nodeCount; i++) {
+                int u = toInternal(i);
+                distances[i] = u < (int)result.size() ? result[u] : INF;
+            }
+        }
+        if (strcmp(engine, "heap") == 0 && updatesPath != NULL) {
+            // Compute the tree once, then repair it after every weight update
+            std::vector<ArcUpdate> updates = readArcUpdates(updatesPath);
+            makeGraphWritable(graph);
+            TreeRepair repair;
+            initTreeRepair(repair, graph, repairLimit);
+            computeTree(graph, state, toInternal(startNode));
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            for (size_t k = 0; k < updates.size(); k++) {
+                int from = toInternal(updates[k].from);
+                int to = toInternal(updates[k].to);
+                int previous = setArcWeight(graph, reverseGraph, from, to, updates[k].weight);
+                dialBucketCount = std::max(dialBucketCount, updates[k].weight + 1);
+                repairTree(graph, reverseGraph, state, toInternal(startNode), repair, from, to, previous, updates[k].weight);
+            }
+            std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+            std::cerr << "Applied " << updates.size() << " updates in " << std::chrono::duration<double>(end - start).count()
+                      << " s: " << repair.repairs << " repaired (" << repair.settledNodes << " nodes settled), "
+                      << repair.recomputations << " full recomputations" << std::endl;
+        } else if (strcmp(engine, "heap") == 0) {
+            dijkstra(graph, state, toInternal(startNode), -1);
+        }
+        recordPhase(stats, "search", searchStart);
+        if (stats.hasHardware) {
+            stopPerfCounters(stats.hardware);
+        }
+        addCounters(stats.counters, state.counters);
+
+        std::chrono::steady_clock::time_point outputStart = std::chrono::steady_clock::now();
+        if (strcmp(engine, "heap") == 0) {
+            for (int i = 0; i < graph.nodeCount; i++) {
+                distances[i] = searchDistance(state, toInternal(i));
+            }
+            if (treePath != NULL) {
+                saveShortestPathTree(state, startNode, graph.nodeCount, treePath);
+            }
+        }
+        recordPhase(stats, "output", outputStart);
+        if (validate) {
+            std::chrono::steady_clock::time_point validateStart = std::chrono::steady_clock::now();
+            // Reference run: the binary heap Dijkstra
+            BinaryHeapQueue reference(state);
+            dijkstraWithQueue(graph, state, reference, toInternal(startNode), -1);
+            int mismatches = 0;
+            for (int i = 0; i < graph.nodeCount; i++) {
+                mismatches += distances[i] != searchDistance(state, toInternal(i));
+            }
+            std::cerr << "Validation against heap Dijkstra: " << mismatches << " mismatching nodes" << std::endl;
+            if (mismatches > 0) {
+                throw std::runtime_error("distances differ from the binary heap Dijkstra");
+            }
+            recordPhase(stats, "validate", validateStart);
+        }
+
+        // Output the shortest distances from the start node to all other nodes
+        outputStart = std::chrono::steady_clock::now();
+        if (outputToStdout || outputToFile) {
+            ResultWriter writer;
+            openResultWriter(writer, outputToStdout, outputToFile ? "output.txt" : NULL);
+            for (int i = 1; i < graph.nodeCount; i++) {
+                writeDistanceLine(writer, startNode, i, distances[i]);
+            }
+            closeResultWriter(writer);
+        }
+        if (binaryOutPath != NULL) {
+            saveBinaryDistances(distances.data(), graph.nodeCount, binaryOutPath);
+        }
+        recordPhase(stats, "output", outputStart);
+        if (statsPath != NULL) {
+            writeRunStats(stats, graph, engine, queueName, statsPath);
+        }
+
+        // Free dynamically allocated memory for the graph and the search
+        freeSearchState(state);
+        freeGraph(reverseGraph);
+        freeGraph(graph);
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
 
     return 0;
 }